@@ -1,4 +1,4 @@
-QT       += core gui
+QT       += core gui network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -9,11 +9,45 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    branchingstrategy.cpp \
+    distributed.cpp \
+    headless.cpp \
+    instancegenerator.cpp \
     main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    matrixio.cpp \
+    matrixkernels.cpp \
+    presolve.cpp \
+    reductionstate.cpp \
+    searchestimator.cpp \
+    searchtrace.cpp \
+    searchtreemodel.cpp \
+    solverclient.cpp \
+    solverprotocol.cpp \
+    solverserver.cpp \
+    sparsegraph.cpp \
+    tour.cpp \
+    tspsolver.cpp
 
 HEADERS += \
-    mainwindow.h
+    branchingstrategy.h \
+    distributed.h \
+    headless.h \
+    instancegenerator.h \
+    mainwindow.h \
+    matrixio.h \
+    matrixkernels.h \
+    presolve.h \
+    reductionstate.h \
+    searchestimator.h \
+    searchtrace.h \
+    searchtreemodel.h \
+    solverclient.h \
+    solverprotocol.h \
+    solverserver.h \
+    sparsegraph.h \
+    tour.h \
+    tspsolver.h
 
 FORMS += \
     mainwindow.ui
@@ -0,0 +1,144 @@
+#include "branchingstrategy.h"
+
+#include "tspsolver.h"
+
+#include <algorithm>
+
+std::unique_ptr<BranchingStrategy> BranchingStrategy::create(const Type type)
+{
+    switch (type) {
+    case Type::MAX_PENALTY:
+        return std::unique_ptr<BranchingStrategy>(new MaxPenaltyBranching());
+    case Type::STRONG:
+        return std::unique_ptr<BranchingStrategy>(new StrongBranching());
+    case Type::MOST_CONSTRAINED:
+        return std::unique_ptr<BranchingStrategy>(new MostConstrainedBranching());
+    }
+    return std::unique_ptr<BranchingStrategy>(new MaxPenaltyBranching());
+}
+
+bool BranchingStrategy::typeFromName(const QString &name, Type &type)
+{
+    const QStringList names = typeNames();
+    const int index = names.indexOf(name.toLower());
+    if (index < 0)
+        return false;
+    type = Type(index);
+    return true;
+}
+
+QString BranchingStrategy::typeName(const Type type)
+{
+    return typeNames().value(int(type));
+}
+
+QStringList BranchingStrategy::typeNames()
+{
+    return {"max-penalty", "strong", "most-constrained"};
+}
+
+bool MaxPenaltyBranching::choose(
+        const QVector<float> &mat,
+        const int size,
+        const QVector<QPoint> &currentRoute,
+        QPoint &zeroPos,
+        float &score)
+{
+    Q_UNUSED(currentRoute);
+    return TspSolver::findPivotZero(mat, size, zeroPos, score);
+}
+
+bool StrongBranching::choose(
+        const QVector<float> &mat,
+        const int size,
+        const QVector<QPoint> &currentRoute,
+        QPoint &zeroPos,
+        float &score)
+{
+    TspSolver::fillPenalties(mat, size, m_rowPenalty, m_colPenalty);
+    m_candidates.clear();
+    for (int col = 0; col < size; ++col)
+        for (int row = 0; row < size; ++row)
+            if (qFuzzyIsNull(TspSolver::get(mat, size, row, col)))
+                m_candidates.push_back({QPoint(row, col), m_rowPenalty[row] + m_colPenalty[col]});
+    if (m_candidates.isEmpty())
+        return false;
+
+    // Highest penalties first, scan order on ties as in MaxPenaltyBranching
+    const int nCandidates = qMin(m_nCandidates, m_candidates.size());
+    std::partial_sort(m_candidates.begin(), m_candidates.begin() + nCandidates, m_candidates.end(),
+                      [](const Candidate &a, const Candidate &b) {
+        if (a.penalty != b.penalty)
+            return a.penalty > b.penalty;
+        return a.zeroPos.y() != b.zeroPos.y() ? a.zeroPos.y() < b.zeroPos.y() : a.zeroPos.x() < b.zeroPos.x();
+    });
+
+    // Product of child bound increases, so both children have to move the bound
+    const float minGain = 1e-6f;
+    float bestProduct = -1.f;
+    for (int c = 0; c < nCandidates; ++c) {
+        const Candidate &candidate = m_candidates[c];
+        m_childMat = mat;
+        TspSolver::includePath(m_childMat, size, candidate.zeroPos, currentRoute);
+        const float includeGain = TspSolver::simplifyMatrix(m_childMat, size);
+        ++m_lookaheads;
+        const float product = qMax(includeGain, minGain) * qMax(candidate.penalty, minGain);
+        if (product > bestProduct) {
+            bestProduct = product;
+            zeroPos = candidate.zeroPos;
+            score = candidate.penalty;
+        }
+    }
+    return true;
+}
+
+bool MostConstrainedBranching::choose(
+        const QVector<float> &mat,
+        const int size,
+        const QVector<QPoint> &currentRoute,
+        QPoint &zeroPos,
+        float &score)
+{
+    Q_UNUSED(currentRoute);
+    // City line with the fewest paths left, row (successor) before column (predecessor) on ties
+    int bestCount = size + 1;
+    int bestLine = -1;
+    bool isBestRow = true;
+    for (int pass = 0; pass < 2; ++pass) {
+        const bool isRow = (pass == 0);
+        for (int line = 0; line < size; ++line) {
+            int count = 0;
+            for (int i = 0; i < size; ++i) {
+                const float value = isRow ? TspSolver::get(mat, size, line, i) : TspSolver::get(mat, size, i, line);
+                if (value >= 0.f)
+                    ++count;
+            }
+            if (count > 0 && count < bestCount) {
+                bestCount = count;
+                bestLine = line;
+                isBestRow = isRow;
+            }
+        }
+    }
+    if (bestLine < 0)
+        return false;
+
+    TspSolver::fillPenalties(mat, size, m_rowPenalty, m_colPenalty);
+    float bestScore = -1.f;
+    for (int i = 0; i < size; ++i) {
+        const int row = isBestRow ? bestLine : i;
+        const int col = isBestRow ? i : bestLine;
+        const float value = TspSolver::get(mat, size, row, col);
+        if (value < 0.f || !qFuzzyIsNull(value))
+            continue;
+        const float penalty = m_rowPenalty[row] + m_colPenalty[col];
+        if (penalty > bestScore) {
+            bestScore = penalty;
+            zeroPos = QPoint(row, col);
+        }
+    }
+    if (bestScore < 0.f) // Line of a reduced matrix always has a zero, but keep the search going anyway
+        return TspSolver::findPivotZero(mat, size, zeroPos, score);
+    score = bestScore;
+    return true;
+}
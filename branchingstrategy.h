@@ -0,0 +1,107 @@
+#ifndef BRANCHINGSTRATEGY_H
+#define BRANCHINGSTRATEGY_H
+
+#include <QVector>
+#include <QPoint>
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+
+// Chooses the path to branch on in a reduced branch and bound node:
+// include it in the tour or exclude it. The path is always a zero of the
+// reduced matrix and score is its penalty (row + column minimum without it),
+// which is the bound increase of the exclude branch.
+//
+//   MAX_PENALTY     - zero with the highest penalty (classic Little's rule)
+//   STRONG          - look-ahead: top candidates by penalty are included and
+//                     reduced, the one with the best pair of child bounds wins
+//   MOST_CONSTRAINED - zero of the city (row or column) with the fewest
+//                     paths left, highest penalty inside it
+class BranchingStrategy
+{
+public:
+    enum class Type : int {
+        MAX_PENALTY,
+        STRONG,
+        MOST_CONSTRAINED
+    };
+
+    virtual ~BranchingStrategy() = default;
+
+    virtual Type type() const = 0;
+    // false if mat has no zeros left
+    virtual bool choose(
+            const QVector<float> &mat,
+            const int size,
+            const QVector<QPoint> &currentRoute,
+            QPoint &zeroPos,
+            float &score) = 0;
+
+    // Child bounds computed ahead, only STRONG does it
+    size_t lookaheads() const { return m_lookaheads; }
+    void resetStatistics() { m_lookaheads = 0; }
+
+    static std::unique_ptr<BranchingStrategy> create(const Type type);
+    static bool typeFromName(const QString &name, Type &type);
+    static QString typeName(const Type type);
+    static QStringList typeNames();
+
+protected:
+    size_t m_lookaheads = 0;
+    // Warm buffers of the penalties
+    QVector<float> m_rowPenalty;
+    QVector<float> m_colPenalty;
+};
+
+class MaxPenaltyBranching : public BranchingStrategy
+{
+public:
+    Type type() const override { return Type::MAX_PENALTY; }
+    bool choose(
+            const QVector<float> &mat,
+            const int size,
+            const QVector<QPoint> &currentRoute,
+            QPoint &zeroPos,
+            float &score) override;
+};
+
+class StrongBranching : public BranchingStrategy
+{
+public:
+    static constexpr int defaultCandidates = 5;
+
+    explicit StrongBranching(const int nCandidates = defaultCandidates) : m_nCandidates(qMax(1, nCandidates)) {}
+
+    Type type() const override { return Type::STRONG; }
+    bool choose(
+            const QVector<float> &mat,
+            const int size,
+            const QVector<QPoint> &currentRoute,
+            QPoint &zeroPos,
+            float &score) override;
+
+private:
+    struct Candidate {
+        QPoint zeroPos;
+        float penalty = 0.f;
+    };
+
+    int m_nCandidates = defaultCandidates;
+    QVector<Candidate> m_candidates;
+    QVector<float> m_childMat;
+};
+
+class MostConstrainedBranching : public BranchingStrategy
+{
+public:
+    Type type() const override { return Type::MOST_CONSTRAINED; }
+    bool choose(
+            const QVector<float> &mat,
+            const int size,
+            const QVector<QPoint> &currentRoute,
+            QPoint &zeroPos,
+            float &score) override;
+};
+
+#endif // BRANCHINGSTRATEGY_H
@@ -0,0 +1,404 @@
+#include "distributed.h"
+
+#include "presolve.h"
+#include "solverprotocol.h"
+
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QThreadPool>
+
+DistributedCoordinator::DistributedCoordinator(
+        const QVector<float> &mat,
+        const int size,
+        const AnswerType answerType,
+        QObject *parent)
+    : QObject(parent)
+    , m_mat(mat)
+    , m_size(size)
+    , m_answerType(answerType)
+{
+    connect(&m_server, &QLocalServer::newConnection, this, &DistributedCoordinator::onNewConnection);
+}
+
+DistributedCoordinator::~DistributedCoordinator()
+{
+    for (auto it = m_workers.begin(); it != m_workers.end(); ++it)
+        it.key()->abort(); // Workers quit when coordinator is gone
+    for (QProcess *process : m_processes) {
+        if (!process->waitForFinished(1000))
+            process->kill();
+        process->waitForFinished(1000);
+    }
+}
+
+bool DistributedCoordinator::start(QString &error)
+{
+    m_startTime = std::chrono::steady_clock::now();
+    const TspSolver::Subproblem root = m_presolve ? presolve() : TspSolver::Subproblem();
+    if (!m_result.presolve.isExhausted)
+        m_queue = TspSolver::splitProblem(m_mat, m_size, root, m_workerCount * m_splitFactor, m_answerType, m_result.length, m_result.routes);
+    m_incumbent = m_result.length;
+    if (m_queue.isEmpty()) { // Tree is too small to distribute
+        finish();
+        return true;
+    }
+
+    const QString name = QString("dvm-coordinator-%1").arg(QCoreApplication::applicationPid());
+    QLocalServer::removeServer(name);
+    m_server.setSocketOptions(QLocalServer::UserAccessOption);
+    if (!m_server.listen(name)) {
+        error = QString("Can't listen on %1: %2").arg(name).arg(m_server.errorString());
+        return false;
+    }
+
+    m_statistics.nWorkers = m_workerCount;
+    for (int w = 0; w < m_workerCount; ++w) {
+        QProcess *process = new QProcess(this);
+        process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        connect(process, &QProcess::errorOccurred, this, &DistributedCoordinator::checkWorkerProcesses);
+        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &DistributedCoordinator::checkWorkerProcesses);
+        process->start(QCoreApplication::applicationFilePath(), {"--worker", name});
+        m_processes.push_back(process);
+    }
+    return true;
+}
+
+void DistributedCoordinator::onNewConnection()
+{
+    while (QLocalSocket *socket = m_server.nextPendingConnection()) {
+        m_workers.insert(socket, Worker());
+        connect(socket, &QLocalSocket::readyRead, this, &DistributedCoordinator::onReadyRead);
+        connect(socket, &QLocalSocket::disconnected, this, &DistributedCoordinator::onDisconnected);
+
+        QJsonObject problem;
+        problem.insert("type", "problem");
+        problem.insert("size", m_size);
+        problem.insert("matrix", SolverProtocol::matrixToJson(m_mat, m_size));
+        problem.insert("answerType", m_answerType == AnswerType::ALL ? "all" : "first");
+        problem.insert("nodeLimit", double(m_nodeLimit));
+        problem.insert("branching", BranchingStrategy::typeName(m_result.branching));
+        send(socket, problem);
+    }
+    dispatch();
+}
+
+void DistributedCoordinator::onReadyRead()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+    if (socket == nullptr || !m_workers.contains(socket))
+        return;
+    m_workers[socket].buffer.append(socket->readAll());
+
+    QJsonObject message;
+    SolverProtocol::FrameStatus status;
+    while ((status = SolverProtocol::takeFrame(m_workers[socket].buffer, message)) == SolverProtocol::FrameStatus::READY)
+        handleMessage(socket, message);
+    if (status == SolverProtocol::FrameStatus::INVALID)
+        socket->abort();
+    else
+        dispatch();
+}
+
+void DistributedCoordinator::onDisconnected()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+    if (socket == nullptr)
+        return;
+    const Worker worker = m_workers.take(socket);
+    socket->deleteLater();
+    if (m_isFinished)
+        return;
+    if (worker.busy) // Give the task to somebody else
+        m_queue.push_back(worker.task);
+    if (m_workers.isEmpty())
+        finish("All workers have exited");
+    else
+        dispatch();
+}
+
+void DistributedCoordinator::handleMessage(QLocalSocket *socket, const QJsonObject &message)
+{
+    const QString type = message.value("type").toString();
+    if (type == "record") { // Keep the tour, a retry of the task can't find it against the lowered incumbent
+        const float rating = float(message.value("length").toDouble());
+        const Tour tour = SolverProtocol::tourFromJson(message.value("route"));
+        if (tour.size() == m_size)
+            mergeRoutes(rating, {tour});
+        else
+            updateIncumbent(rating);
+        return;
+    }
+    if (type != "result")
+        return;
+
+    Worker &worker = m_workers[socket];
+    worker.busy = false;
+    m_statistics.nodes += size_t(message.value("nodes").toDouble());
+    m_result.lookaheads += size_t(message.value("lookaheads").toDouble());
+
+    QVector<Tour> routes;
+    for (const QJsonValue &route : message.value("routes").toArray()) {
+        const Tour tour = SolverProtocol::tourFromJson(route);
+        if (tour.size() == m_size)
+            routes.push_back(tour);
+    }
+    if (!routes.isEmpty())
+        mergeRoutes(float(message.value("length").toDouble()), routes);
+
+    const QJsonArray open = message.value("open").toArray();
+    if (!open.isEmpty())
+        ++m_statistics.nResplits;
+    for (const QJsonValue &subproblem : open)
+        m_queue.push_back(SolverProtocol::subproblemFromJson(subproblem.toObject()));
+}
+
+void DistributedCoordinator::dispatch()
+{
+    if (m_isFinished)
+        return;
+    for (auto it = m_workers.begin(); it != m_workers.end(); ++it) {
+        if (it.value().busy)
+            continue;
+        TspSolver::Subproblem subproblem;
+        if (!takeBestSubproblem(subproblem))
+            break;
+
+        QJsonObject task;
+        task.insert("type", "task");
+        task.insert("subproblem", SolverProtocol::subproblemToJson(subproblem));
+        task.insert("incumbent", double(m_incumbent));
+        send(it.key(), task);
+        it.value().busy = true;
+        it.value().task = subproblem;
+        ++m_statistics.nTasks;
+    }
+
+    bool isBusy = false;
+    for (const Worker &worker : m_workers)
+        isBusy = isBusy || worker.busy;
+    if (!isBusy && m_queue.isEmpty() && !m_workers.isEmpty())
+        finish();
+}
+
+void DistributedCoordinator::updateIncumbent(const float rating)
+{
+    if (rating >= m_incumbent)
+        return;
+    m_incumbent = rating;
+    QJsonObject message;
+    message.insert("type", "incumbent");
+    message.insert("length", double(rating));
+    for (auto it = m_workers.begin(); it != m_workers.end(); ++it)
+        send(it.key(), message);
+}
+
+void DistributedCoordinator::mergeRoutes(const float rating, const QVector<Tour> &routes)
+{
+    if (rating < m_result.length) {
+        m_result.length = rating;
+        m_result.routes = routes;
+    }
+    else if (rating == m_result.length && m_answerType == AnswerType::ALL) {
+        // Subproblems are disjoint, but a record comes again with its result or a retried task
+        for (const Tour &tour : routes)
+            if (!m_result.routes.contains(tour))
+                m_result.routes.push_back(tour);
+    }
+    updateIncumbent(rating);
+}
+
+bool DistributedCoordinator::takeBestSubproblem(TspSolver::Subproblem &subproblem)
+{
+    // Lowest bound first, deeper subproblem on ties
+    int bestIndex = -1;
+    for (int i = 0; i < m_queue.size(); ++i) {
+        const TspSolver::Subproblem &candidate = m_queue[i];
+        if (TspSolver::isWorseThanRecord(candidate.bound, m_incumbent, m_answerType))
+            continue;
+        if (bestIndex < 0
+                || candidate.bound < m_queue[bestIndex].bound
+                || (candidate.bound == m_queue[bestIndex].bound && candidate.included.size() > m_queue[bestIndex].included.size()))
+            bestIndex = i;
+    }
+    if (bestIndex < 0) {
+        m_queue.clear(); // Everything left is pruned
+        return false;
+    }
+    subproblem = m_queue[bestIndex];
+    m_queue[bestIndex] = m_queue.last();
+    m_queue.removeLast();
+    return true;
+}
+
+void DistributedCoordinator::checkWorkerProcesses()
+{
+    if (m_isFinished || !m_workers.isEmpty())
+        return;
+    for (const QProcess *process : m_processes)
+        if (process->state() != QProcess::NotRunning)
+            return;
+    finish("Worker processes have exited");
+}
+
+TspSolver::Subproblem DistributedCoordinator::presolve()
+{
+    QVector<float> presolved = m_mat;
+    QVector<QPoint> fixedRoute;
+    m_result.presolve = Presolve::run(presolved, m_size, m_answerType, fixedRoute, m_heuristicTour);
+    if (!m_heuristicTour.isEmpty()) {
+        m_result.length = m_result.presolve.upperBound;
+        if (m_answerType == AnswerType::FIRST)
+            m_result.routes = {m_heuristicTour};
+        else // Workers search equal tours again, their bound sums may round above the heuristic length
+            m_result.length += Presolve::tolerance(m_result.presolve.upperBound);
+    }
+
+    // Workers rebuild subproblems from m_mat, so fixed paths stay in it with their costs
+    // and only removed paths are taken over. Paths closed by the fixed ones are removed
+    // too, every subproblem includes the fixed paths anyway.
+    QVector<bool> isFixedRow(m_size, false);
+    QVector<bool> isFixedCol(m_size, false);
+    for (const QPoint &path : fixedRoute) {
+        isFixedRow[path.x()] = true;
+        isFixedCol[path.y()] = true;
+    }
+    for (int col = 0; col < m_size; ++col)
+        for (int row = 0; row < m_size; ++row)
+            if (!isFixedRow[row] && !isFixedCol[col] && TspSolver::get(presolved, m_size, row, col) < 0.f)
+                TspSolver::get(m_mat, m_size, row, col) = -1.f;
+
+    TspSolver::Subproblem root;
+    root.included = fixedRoute;
+    root.bound = m_result.presolve.lowerBound;
+    return root;
+}
+
+void DistributedCoordinator::finish(const QString &error)
+{
+    if (m_isFinished)
+        return;
+    m_isFinished = true;
+    m_error = error;
+
+    QJsonObject quit;
+    quit.insert("type", "quit");
+    for (auto it = m_workers.begin(); it != m_workers.end(); ++it) {
+        send(it.key(), quit);
+        it.key()->flush();
+    }
+    m_server.close();
+
+    if (m_answerType == AnswerType::ALL && !m_heuristicTour.isEmpty() && m_result.routes.isEmpty()) { // Nothing found in time
+        m_result.length = m_result.presolve.upperBound;
+        m_result.routes = {m_heuristicTour};
+    }
+    m_result.nodes = m_statistics.nodes;
+    m_statistics.timeInNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_startTime).count();
+    m_result.timeInNs = m_statistics.timeInNs;
+    QMetaObject::invokeMethod(this, &DistributedCoordinator::finished, Qt::QueuedConnection);
+}
+
+void DistributedCoordinator::send(QLocalSocket *socket, const QJsonObject &message)
+{
+    if (socket->state() == QLocalSocket::ConnectedState)
+        socket->write(SolverProtocol::encodeFrame(message));
+}
+
+DistributedWorker::DistributedWorker(QObject *parent)
+    : QObject(parent)
+    , m_sharedBound(std::numeric_limits<float>::max())
+{
+    connect(&m_socket, &QLocalSocket::readyRead, this, &DistributedWorker::onReadyRead);
+    connect(&m_socket, &QLocalSocket::disconnected, qApp, &QCoreApplication::quit);
+    m_solver.setSharedBound(&m_sharedBound);
+    m_solver.setRecordCallback([this](const float rating, const Tour &tour) {
+        QMetaObject::invokeMethod(this, [this, rating, tour]() {
+            QJsonObject record;
+            record.insert("type", "record");
+            record.insert("length", double(rating));
+            record.insert("route", SolverProtocol::tourToJson(tour));
+            m_socket.write(SolverProtocol::encodeFrame(record));
+        }, Qt::QueuedConnection);
+    });
+}
+
+DistributedWorker::~DistributedWorker()
+{
+    QThreadPool::globalInstance()->waitForDone();
+}
+
+bool DistributedWorker::connectToCoordinator(const QString &name, QString &error)
+{
+    m_socket.connectToServer(name);
+    if (!m_socket.waitForConnected(5000)) {
+        error = m_socket.errorString();
+        return false;
+    }
+    return true;
+}
+
+void DistributedWorker::onReadyRead()
+{
+    m_buffer.append(m_socket.readAll());
+    QJsonObject message;
+    SolverProtocol::FrameStatus status;
+    while ((status = SolverProtocol::takeFrame(m_buffer, message)) == SolverProtocol::FrameStatus::READY)
+        handleMessage(message);
+    if (status == SolverProtocol::FrameStatus::INVALID)
+        m_socket.abort();
+}
+
+void DistributedWorker::handleMessage(const QJsonObject &message)
+{
+    const QString type = message.value("type").toString();
+    if (type == "problem") {
+        m_size = message.value("size").toInt();
+        SolverProtocol::matrixFromJson(message.value("matrix").toArray(), m_size, m_mat);
+        m_answerType = message.value("answerType").toString() == "all" ? AnswerType::ALL : AnswerType::FIRST;
+        m_nodeLimit = size_t(message.value("nodeLimit").toDouble());
+        BranchingStrategy::Type branching = BranchingStrategy::Type::MAX_PENALTY;
+        BranchingStrategy::typeFromName(message.value("branching").toString(), branching);
+        m_solver.setBranching(branching);
+    }
+    else if (type == "task") {
+        const float incumbent = float(message.value("incumbent").toDouble());
+        startTask(SolverProtocol::subproblemFromJson(message.value("subproblem").toObject()), incumbent);
+    }
+    else if (type == "incumbent") {
+        const float rating = float(message.value("length").toDouble());
+        if (rating < m_sharedBound.load())
+            m_sharedBound.store(rating);
+    }
+    else if (type == "quit")
+        QCoreApplication::quit();
+}
+
+void DistributedWorker::startTask(const TspSolver::Subproblem &subproblem, const float incumbent)
+{
+    if (incumbent < m_sharedBound.load())
+        m_sharedBound.store(incumbent);
+    QThreadPool::globalInstance()->start([this, subproblem]() {
+        m_solver.setNodeLimit(m_nodeLimit);
+        const TspSolver::Result result = m_solver.solveSubproblem(m_mat, m_size, subproblem, m_answerType, m_sharedBound.load());
+
+        QJsonObject message;
+        message.insert("type", "result");
+        message.insert("nodes", double(result.nodes));
+        message.insert("lookaheads", double(result.lookaheads));
+        if (result.hasRoute()) {
+            message.insert("length", double(result.length));
+            QJsonArray routes;
+            for (const Tour &tour : result.routes)
+                routes.append(SolverProtocol::tourToJson(tour));
+            message.insert("routes", routes);
+        }
+        QJsonArray open;
+        for (const TspSolver::Subproblem &openSubproblem : result.openSubproblems)
+            open.append(SolverProtocol::subproblemToJson(openSubproblem));
+        message.insert("open", open);
+
+        QMetaObject::invokeMethod(this, [this, message]() {
+            m_socket.write(SolverProtocol::encodeFrame(message));
+        }, Qt::QueuedConnection);
+    });
+}
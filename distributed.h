@@ -0,0 +1,136 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include <QObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QProcess>
+#include <QHash>
+#include <QJsonObject>
+
+#include <atomic>
+#include <chrono>
+
+#include "tspsolver.h"
+
+// Multi-process branch and bound.
+// Coordinator splits the top of the search tree into subproblems and hands
+// them to worker processes (DVM --worker <name>) over a local socket, best
+// bound first. Workers solve a subproblem until their node limit and send
+// the unexplored rest back, so long subtrees are re-split between all of
+// them. Every new record is broadcast to all workers for pruning.
+//
+// Messages (SolverProtocol frames):
+//   coordinator -> worker: problem (matrix and solver settings), task, incumbent, quit
+//   worker -> coordinator: record (length and tour), result
+class DistributedCoordinator : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Statistics {
+        int nWorkers = 0;
+        size_t nTasks = 0;
+        size_t nResplits = 0; // Subproblems returned unfinished by workers
+        size_t nodes = 0;
+        size_t timeInNs = 0;
+    };
+
+    DistributedCoordinator(const QVector<float> &mat, const int size, const AnswerType answerType, QObject *parent = nullptr);
+    ~DistributedCoordinator();
+
+    void setWorkerCount(const int count) { m_workerCount = qMax(1, count); }
+    // Initial number of subproblems per worker
+    void setSplitFactor(const int factor) { m_splitFactor = qMax(1, factor); }
+    // Nodes a worker explores before returning the rest of its subproblem
+    void setNodeLimit(const size_t nodeLimit) { m_nodeLimit = nodeLimit; }
+    // Run Presolve before splitting, workers get the pruned matrix
+    void setPresolve(const bool enabled) { m_presolve = enabled; }
+    void setBranching(const BranchingStrategy::Type type) { m_result.branching = type; }
+
+    bool start(QString &error);
+
+    const TspSolver::Result &result() const { return m_result; }
+    const Statistics &statistics() const { return m_statistics; }
+    QString errorString() const { return m_error; }
+
+signals:
+    void finished();
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onDisconnected();
+
+private:
+    struct Worker {
+        QByteArray buffer;
+        bool busy = false;
+        TspSolver::Subproblem task;
+    };
+
+    void handleMessage(QLocalSocket *socket, const QJsonObject &message);
+    void dispatch();
+    void updateIncumbent(const float rating);
+    void mergeRoutes(const float rating, const QVector<Tour> &routes);
+    bool takeBestSubproblem(TspSolver::Subproblem &subproblem);
+    void checkWorkerProcesses();
+    TspSolver::Subproblem presolve();
+    void finish(const QString &error = QString());
+    static void send(QLocalSocket *socket, const QJsonObject &message);
+
+private:
+    QVector<float> m_mat;
+    int m_size = 0;
+    AnswerType m_answerType = AnswerType::FIRST;
+    int m_workerCount = 1;
+    int m_splitFactor = 4;
+    size_t m_nodeLimit = 100000;
+    bool m_presolve = false;
+
+    QLocalServer m_server;
+    QVector<QProcess *> m_processes;
+    QHash<QLocalSocket *, Worker> m_workers;
+    QVector<TspSolver::Subproblem> m_queue;
+    float m_incumbent = std::numeric_limits<float>::max();
+    bool m_isFinished = false;
+    std::chrono::steady_clock::time_point m_startTime;
+
+    TspSolver::Result m_result;
+    Tour m_heuristicTour; // Presolve upper bound tour, empty if none
+    Statistics m_statistics;
+    QString m_error;
+};
+
+// Worker process side, see DistributedCoordinator
+class DistributedWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DistributedWorker(QObject *parent = nullptr);
+    ~DistributedWorker();
+
+    bool connectToCoordinator(const QString &name, QString &error);
+
+private slots:
+    void onReadyRead();
+
+private:
+    void handleMessage(const QJsonObject &message);
+    void startTask(const TspSolver::Subproblem &subproblem, const float incumbent);
+
+private:
+    QLocalSocket m_socket;
+    QByteArray m_buffer;
+
+    QVector<float> m_mat;
+    int m_size = 0;
+    AnswerType m_answerType = AnswerType::FIRST;
+    size_t m_nodeLimit = 0;
+
+    TspSolver m_solver; // Used only by the task thread
+    std::atomic<float> m_sharedBound;
+};
+
+#endif // DISTRIBUTED_H
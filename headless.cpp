@@ -0,0 +1,365 @@
+#include "headless.h"
+
+#include "distributed.h"
+#include "matrixio.h"
+#include "solverclient.h"
+#include "solverprotocol.h"
+#include "solverserver.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QThread>
+
+bool Headless::isHeadless(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        const QString arg = QString::fromLocal8Bit(argv[i]);
+        if (arg == "--server" || arg == "--client" || arg == "--coordinator" || arg == "--worker" || arg == "--generate"
+                || arg == "--solve")
+            return true;
+    }
+    return false;
+}
+
+int Headless::run(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Travelling salesman problem solver (headless mode)");
+    parser.addHelpOption();
+    const QCommandLineOption serverOption("server", "Run solver server on local socket <name>.", "name");
+    const QCommandLineOption clientOption("client", "Send matrices to solver server <name>.", "name");
+    const QCommandLineOption coordinatorOption("coordinator", "Solve matrix <file> with worker processes.", "file");
+    const QCommandLineOption workerOption("worker", "Run as worker of coordinator <name>.", "name");
+    const QCommandLineOption solveOption("solve", "Solve matrix <file> in this process.", "file");
+    const QCommandLineOption traceOption("trace", "Record search tree of --solve into <file>: Chrome trace for *.json, collapsed stacks otherwise.", "file");
+    const QCommandLineOption estimateOption("estimate", "Estimate tree size and remaining time of --solve: progress on stderr, \"estimate\" in the result.");
+    const QCommandLineOption workersOption("workers", "Number of solver threads or worker processes.", "count", QString::number(qMax(1, QThread::idealThreadCount())));
+    const QCommandLineOption splitOption("split", "Initial subproblems per worker process.", "count", "4");
+    const QCommandLineOption nodeLimitOption("node-limit", "Nodes a worker explores before returning the rest of its subproblem.", "count", "100000");
+    const QCommandLineOption queueOption("queue", "Maximum number of queued requests.", "count", "1024");
+    const QCommandLineOption queueMemoryOption("queue-memory", "Maximum memory of the matrices of queued requests in MB.", "MB", "1024");
+    const QCommandLineOption timeLimitOption("time-limit", "Time limit per request in ms, 0 for none.", "ms", "0");
+    const QCommandLineOption answerOption("answer", "Answer type: first or all.", "type", "first");
+    const QCommandLineOption randomOption("random", "Send <count> generated matrices.", "count", "0");
+    const QCommandLineOption generateOption("generate", "Write generated matrix of <type> (" + InstanceGenerator::typeNames().join(", ") + ").", "type");
+    const QCommandLineOption typeOption("type", "Type of generated matrices in client mode.", "type", "uniform");
+    const QCommandLineOption sizeOption("size", "Number of cities in generated matrices.", "n", "10");
+    const QCommandLineOption seedOption("seed", "Seed of generated matrices.", "seed", "1");
+    const QCommandLineOption maxDistanceOption("max-distance", "Distance scale of generated matrices.", "distance", "1000");
+    const QCommandLineOption outOption("out", "Output matrix file.", "file");
+    const QCommandLineOption presolveOption("presolve", "Run presolve (path removal and fixing) before branch and bound.");
+    const QCommandLineOption branchingOption("branching", "Branching rule (" + BranchingStrategy::typeNames().join(", ") + "), comma separated list or \"all\" to compare them in --solve and --client modes.", "rules", "max-penalty");
+    parser.addOptions({serverOption, clientOption, coordinatorOption, workerOption, solveOption, traceOption, estimateOption, workersOption,
+                       splitOption, nodeLimitOption, queueOption, queueMemoryOption, timeLimitOption,
+                       answerOption, randomOption, generateOption, typeOption, sizeOption,
+                       seedOption, maxDistanceOption, outOption, presolveOption, branchingOption});
+    parser.addPositionalArgument("files", "Matrix files to send in client mode.", "[files...]");
+    parser.process(app);
+
+    const int timeLimitInMs = parser.value(timeLimitOption).toInt();
+    if (parser.isSet(serverOption))
+        return runServer(parser.value(serverOption),
+                         parser.value(workersOption).toInt(),
+                         parser.value(queueOption).toInt(),
+                         parser.value(queueMemoryOption).toLongLong(),
+                         timeLimitInMs);
+    if (parser.isSet(workerOption))
+        return runWorker(parser.value(workerOption));
+
+    InstanceGenerator::Type type = InstanceGenerator::Type::UNIFORM;
+    const QString typeName = parser.isSet(generateOption) ? parser.value(generateOption) : parser.value(typeOption);
+    if (!InstanceGenerator::typeFromName(typeName, type)) {
+        QTextStream(stderr) << "Unknown instance type " << typeName << ", expected one of: " << InstanceGenerator::typeNames().join(", ") << "\n";
+        return 1;
+    }
+    const int size = parser.value(sizeOption).toInt();
+    const quint64 seed = parser.value(seedOption).toULongLong();
+    if (parser.isSet(generateOption))
+        return runGenerator(type, size, seed, parser.value(maxDistanceOption).toInt(), parser.value(outOption));
+
+    const AnswerType answerType = parser.value(answerOption) == "all" ? AnswerType::ALL : AnswerType::FIRST;
+    const bool presolve = parser.isSet(presolveOption);
+    QVector<BranchingStrategy::Type> branchings;
+    if (!parseBranchings(parser.value(branchingOption), branchings)) {
+        QTextStream(stderr) << "Unknown branching rule in " << parser.value(branchingOption) << ", expected: " << BranchingStrategy::typeNames().join(", ") << " or all\n";
+        return 1;
+    }
+    if (parser.isSet(solveOption))
+        return runSolve(parser.value(solveOption), answerType, timeLimitInMs, presolve, branchings, parser.value(traceOption), parser.isSet(estimateOption));
+    if (parser.isSet(coordinatorOption)) {
+        if (branchings.size() != 1) {
+            QTextStream(stderr) << "--coordinator takes a single branching rule\n";
+            return 1;
+        }
+        return runCoordinator(parser.value(coordinatorOption),
+                              parser.value(workersOption).toInt(),
+                              parser.value(splitOption).toInt(),
+                              parser.value(nodeLimitOption).toULongLong(),
+                              answerType,
+                              presolve,
+                              branchings[0]);
+    }
+    return runClient(parser.value(clientOption),
+                     parser.positionalArguments(),
+                     parser.value(randomOption).toInt(),
+                     type,
+                     size,
+                     seed,
+                     answerType,
+                     timeLimitInMs,
+                     presolve,
+                     branchings);
+}
+
+bool Headless::parseBranchings(const QString &names, QVector<BranchingStrategy::Type> &branchings)
+{
+    branchings.clear();
+    if (names == "all") {
+        for (int b = 0; b < BranchingStrategy::typeNames().size(); ++b)
+            branchings.push_back(BranchingStrategy::Type(b));
+        return true;
+    }
+    for (const QString &name : names.split(',', Qt::SkipEmptyParts)) {
+        BranchingStrategy::Type type = BranchingStrategy::Type::MAX_PENALTY;
+        if (!BranchingStrategy::typeFromName(name.trimmed(), type))
+            return false;
+        branchings.push_back(type);
+    }
+    return !branchings.isEmpty();
+}
+
+int Headless::runServer(const QString &name, const int nWorkers, const int maxQueueSize, const qint64 maxQueueMemoryInMb, const int timeLimitInMs)
+{
+    SolverServer server;
+    server.setWorkerCount(nWorkers);
+    server.setMaxQueueSize(maxQueueSize);
+    server.setMaxQueuedBytes(maxQueueMemoryInMb * 1024 * 1024);
+    server.setDefaultTimeLimit(timeLimitInMs);
+    if (!server.listen(name)) {
+        QTextStream(stderr) << "Can't listen on " << name << ": " << server.errorString() << "\n";
+        return 1;
+    }
+    QTextStream(stderr) << "Listening on " << name << " with " << qMax(1, nWorkers) << " workers\n";
+    return QCoreApplication::exec();
+}
+
+int Headless::runClient(
+        const QString &name,
+        const QStringList &files,
+        const int nRandom,
+        const InstanceGenerator::Type type,
+        const int size,
+        const quint64 seed,
+        const AnswerType answerType,
+        const int timeLimitInMs,
+        const bool presolve,
+        const QVector<BranchingStrategy::Type> &branchings)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QVector<QJsonObject> requests;
+    for (const QString &fileName : files) {
+        SparseGraph graph;
+        QString error;
+        if (!MatrixIO::readGraph(fileName, graph, error)) {
+            err << error << "\n";
+            return 1;
+        }
+        // Sparse graphs go as edge lists, so the request size follows the number of edges
+        QVector<float> mat;
+        if (!graph.isSparse())
+            graph.fillMatrix(mat);
+        for (const BranchingStrategy::Type branching : branchings)
+            requests.push_back(graph.isSparse()
+                               ? SolverProtocol::makeRequest(fileName, graph, answerType, timeLimitInMs, presolve, branching)
+                               : SolverProtocol::makeRequest(fileName, mat, graph.size(), answerType, timeLimitInMs, presolve, branching));
+    }
+    for (int r = 0; r < nRandom; ++r) {
+        const InstanceGenerator generator(type, size, seed + quint64(r));
+        QVector<float> mat;
+        generator.fillMatrix(mat);
+        const QString id = QString("%1-%2-seed%3").arg(InstanceGenerator::typeName(type)).arg(size).arg(seed + quint64(r));
+        for (const BranchingStrategy::Type branching : branchings)
+            requests.push_back(SolverProtocol::makeRequest(id, mat, size, answerType, timeLimitInMs, presolve, branching));
+    }
+    if (requests.isEmpty()) {
+        err << "Nothing to send: pass matrix files or --random <count>\n";
+        return 1;
+    }
+
+    SolverClient client;
+    if (!client.connectToServer(name, 5000)) {
+        err << "Can't connect to " << name << ": " << client.errorString() << "\n";
+        return 1;
+    }
+    // Pipeline all requests, the server answers in completion order
+    for (const QJsonObject &request : requests)
+        if (!client.send(request)) {
+            err << "Send failed: " << client.errorString() << "\n";
+            return 1;
+        }
+    int nFailed = 0;
+    for (int r = 0; r < requests.size(); ++r) {
+        QJsonObject response;
+        if (!client.receive(response, -1)) {
+            err << "Receive failed: " << client.errorString() << "\n";
+            return 1;
+        }
+        if (response.value("status").toString() != "ok")
+            ++nFailed;
+        out << QJsonDocument(response).toJson(QJsonDocument::Compact) << "\n";
+        out.flush();
+    }
+    return nFailed == 0 ? 0 : 2;
+}
+
+int Headless::runCoordinator(
+        const QString &fileName,
+        const int nWorkers,
+        const int splitFactor,
+        const size_t nodeLimit,
+        const AnswerType answerType,
+        const bool presolve,
+        const BranchingStrategy::Type branching)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QVector<float> mat;
+    int size = 0;
+    QString error;
+    if (!MatrixIO::readMatrix(fileName, mat, size, error)) {
+        err << error << "\n";
+        return 1;
+    }
+
+    DistributedCoordinator coordinator(mat, size, answerType);
+    coordinator.setWorkerCount(nWorkers);
+    coordinator.setSplitFactor(splitFactor);
+    coordinator.setNodeLimit(nodeLimit);
+    coordinator.setPresolve(presolve);
+    coordinator.setBranching(branching);
+    QObject::connect(&coordinator, &DistributedCoordinator::finished, qApp, &QCoreApplication::quit);
+    if (!coordinator.start(error)) {
+        err << error << "\n";
+        return 1;
+    }
+    QCoreApplication::exec();
+
+    if (!coordinator.errorString().isEmpty()) {
+        err << coordinator.errorString() << "\n";
+        return 1;
+    }
+    const DistributedCoordinator::Statistics &statistics = coordinator.statistics();
+    QJsonObject response = SolverProtocol::makeResponse(fileName, coordinator.result());
+    response.insert("workers", statistics.nWorkers);
+    response.insert("tasks", double(statistics.nTasks));
+    response.insert("resplits", double(statistics.nResplits));
+    out << QJsonDocument(response).toJson(QJsonDocument::Compact) << "\n";
+    return 0;
+}
+
+int Headless::runSolve(
+        const QString &fileName,
+        const AnswerType answerType,
+        const int timeLimitInMs,
+        const bool presolve,
+        const QVector<BranchingStrategy::Type> &branchings,
+        const QString &traceFileName,
+        const bool isEstimating)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    if (!traceFileName.isEmpty() && branchings.size() != 1) {
+        err << "--trace takes a single branching rule\n";
+        return 1;
+    }
+    SparseGraph graph;
+    QString error;
+    if (!MatrixIO::readGraph(fileName, graph, error)) {
+        err << error << "\n";
+        return 1;
+    }
+
+    TspSolver solver;
+    SearchTrace trace;
+    solver.setTimeLimit(size_t(timeLimitInMs));
+    solver.setPresolve(presolve);
+    if (!traceFileName.isEmpty())
+        solver.setTrace(&trace);
+    SearchEstimator estimator;
+    if (isEstimating) {
+        solver.setEstimator(&estimator);
+        solver.setProgressCallback([&err](const SearchEstimator::Estimate &estimate) {
+            err << TspSolver::getEstimateString(estimate) << "\n";
+            err.flush();
+        });
+    }
+    // One line per branching rule for side by side comparison
+    for (const BranchingStrategy::Type branching : branchings) {
+        solver.setBranching(branching);
+        const TspSolver::Result result = solver.solveBranchAndBound(graph, answerType);
+        out << QJsonDocument(SolverProtocol::makeResponse(fileName, result, presolve)).toJson(QJsonDocument::Compact) << "\n";
+        out.flush();
+    }
+
+    if (traceFileName.isEmpty())
+        return 0;
+    const bool isOk = traceFileName.endsWith(".json", Qt::CaseInsensitive)
+            ? trace.writeChromeTrace(traceFileName, error)
+            : trace.writeCollapsedStacks(traceFileName, error);
+    if (!isOk) {
+        err << error << "\n";
+        return 1;
+    }
+    if (trace.isTruncated())
+        err << "Trace is truncated to " << trace.size() << " nodes\n";
+    return 0;
+}
+
+int Headless::runWorker(const QString &name)
+{
+    DistributedWorker worker;
+    QString error;
+    if (!worker.connectToCoordinator(name, error)) {
+        QTextStream(stderr) << "Can't connect to " << name << ": " << error << "\n";
+        return 1;
+    }
+    return QCoreApplication::exec();
+}
+
+int Headless::runGenerator(
+        const InstanceGenerator::Type type,
+        const int size,
+        const quint64 seed,
+        const int maxDistance,
+        const QString &fileName)
+{
+    QTextStream err(stderr);
+    if (fileName.isEmpty() || size < 2) {
+        err << "--generate needs --out <file> and --size of at least 2\n";
+        return 1;
+    }
+
+    const InstanceGenerator generator(type, size, seed, maxDistance);
+    QString error;
+    if (!generator.writeMatrix(fileName, error)) {
+        err << error << "\n";
+        return 1;
+    }
+    if (type == InstanceGenerator::Type::PLANTED) {
+        QTextStream out(stdout);
+        out << "Optimal length = " << generator.plantedLength() << "\n";
+        out << "Optimal tour =";
+        for (const int city : generator.plantedTour())
+            out << ' ' << city;
+        out << "\n";
+    }
+    return 0;
+}
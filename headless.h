@@ -0,0 +1,34 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <QString>
+#include <QStringList>
+
+#include "instancegenerator.h"
+#include "tspsolver.h"
+
+// Command line modes that run without any UI (matrix files may be edge lists, see MatrixIO):
+//   DVM --server <name> [--workers N] [--queue N] [--queue-memory MB] [--time-limit ms]
+//   DVM --client <name> [--random N --type T --size N --seed S] [--answer first|all] [--time-limit ms] [--presolve] [--branching rules] [matrix files...]
+//   DVM --coordinator <matrix file> [--workers N] [--split N] [--node-limit N] [--answer first|all] [--presolve] [--branching rule]
+//   DVM --solve <matrix file> [--answer first|all] [--time-limit ms] [--presolve] [--branching rules] [--trace <file>] [--estimate]
+//   DVM --worker <name> (started by the coordinator)
+//   DVM --generate <type> --out <file> [--size N] [--seed S] [--max-distance D]
+class Headless
+{
+public:
+    static bool isHeadless(int argc, char *argv[]);
+    static int run(int argc, char *argv[]);
+
+private:
+    // Comma separated BranchingStrategy names or "all"
+    static bool parseBranchings(const QString &names, QVector<BranchingStrategy::Type> &branchings);
+    static int runServer(const QString &name, const int nWorkers, const int maxQueueSize, const qint64 maxQueueMemoryInMb, const int timeLimitInMs);
+    static int runClient(const QString &name, const QStringList &files, const int nRandom, const InstanceGenerator::Type type, const int size, const quint64 seed, const AnswerType answerType, const int timeLimitInMs, const bool presolve, const QVector<BranchingStrategy::Type> &branchings);
+    static int runCoordinator(const QString &fileName, const int nWorkers, const int splitFactor, const size_t nodeLimit, const AnswerType answerType, const bool presolve, const BranchingStrategy::Type branching);
+    static int runSolve(const QString &fileName, const AnswerType answerType, const int timeLimitInMs, const bool presolve, const QVector<BranchingStrategy::Type> &branchings, const QString &traceFileName, const bool isEstimating);
+    static int runWorker(const QString &name);
+    static int runGenerator(const InstanceGenerator::Type type, const int size, const quint64 seed, const int maxDistance, const QString &fileName);
+};
+
+#endif // HEADLESS_H
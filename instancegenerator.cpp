@@ -0,0 +1,172 @@
+#include "instancegenerator.h"
+
+#include "tspsolver.h"
+
+#include <QFile>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+
+InstanceGenerator::InstanceGenerator(const Type type, const int size, const quint64 seed, const int maxDistance)
+    : m_type(type)
+    , m_size(size)
+    , m_seed(seed)
+    , m_maxDistance(qMax(2, maxDistance))
+{
+    quint64 state = seed;
+    const auto coordinate = [&]() { return toUnit(nextRandom(state)) * m_maxDistance; };
+
+    if (type == Type::EUCLIDEAN || type == Type::ROAD) {
+        m_points.resize(size);
+        for (QPointF &point : m_points) {
+            const double x = coordinate();
+            point = QPointF(x, coordinate());
+        }
+    }
+    else if (type == Type::CLUSTERED) {
+        const int nClusters = qMax(2, size / 25);
+        QVector<QPointF> centers(nClusters);
+        for (QPointF &center : centers) {
+            const double x = coordinate();
+            center = QPointF(x, coordinate());
+        }
+        // Irwin-Hall sum of 12 uniforms: close to a normal distribution, and plain
+        // arithmetic, so the offsets don't depend on the standard library
+        const double deviation = m_maxDistance / (4.0 * std::sqrt(double(nClusters)));
+        const auto offset = [&]() {
+            double sum = -6.0;
+            for (int i = 0; i < 12; ++i)
+                sum += toUnit(nextRandom(state));
+            return sum * deviation;
+        };
+        m_points.resize(size);
+        for (QPointF &point : m_points) {
+            const QPointF &center = centers[int(nextRandom(state) % quint64(nClusters))];
+            const double x = center.x() + offset();
+            point = QPointF(x, center.y() + offset());
+        }
+    }
+    else if (type == Type::PLANTED) {
+        m_plantedTour.resize(size);
+        for (int city = 0; city < size; ++city)
+            m_plantedTour[city] = city;
+        for (int i = size - 1; i > 1; --i) // Fisher-Yates, tour starts from city 0
+            std::swap(m_plantedTour[i], m_plantedTour[1 + int(nextRandom(state) % quint64(i))]);
+        m_plantedNext.resize(size);
+        for (int i = 0; i < size; ++i)
+            m_plantedNext[m_plantedTour[i]] = m_plantedTour[(i + 1) % size];
+        for (int city = 0; city < size; ++city)
+            m_plantedLength += distance(city, m_plantedNext[city]);
+    }
+}
+
+float InstanceGenerator::distance(const int row, const int col) const
+{
+    if (row == col)
+        return -1.f;
+
+    switch (m_type) {
+    case Type::UNIFORM:
+        return float(1 + cellHash(row, col) % quint64(m_maxDistance));
+    case Type::EUCLIDEAN:
+    case Type::CLUSTERED: {
+        const QPointF delta = m_points[row] - m_points[col];
+        return float(qMax(1.0, std::round(std::sqrt(delta.x() * delta.x() + delta.y() * delta.y())))); // No free paths in dense clusters
+    }
+    case Type::ROAD: {
+        const QPointF delta = m_points[row] - m_points[col];
+        const double straight = std::sqrt(delta.x() * delta.x() + delta.y() * delta.y());
+        const double detour = 1.0 + 0.6 * cellRandom(row, col); // Differs for row->col and col->row
+        return float(qMax(1.0, std::round(straight * detour)));
+    }
+    case Type::PLANTED: {
+        const int half = m_maxDistance / 2;
+        if (m_plantedNext[row] == col)
+            return float(1 + cellHash(row, col) % quint64(half));
+        return float(half + 1 + cellHash(row, col) % quint64(m_maxDistance - half));
+    }
+    }
+    return -1.f;
+}
+
+void InstanceGenerator::fillMatrix(QVector<float> &mat) const
+{
+    mat.resize(m_size * m_size);
+    for (int col = 0; col < m_size; ++col)
+        for (int row = 0; row < m_size; ++row)
+            TspSolver::get(mat, m_size, row, col) = distance(row, col);
+}
+
+bool InstanceGenerator::writeMatrix(const QString &fileName, QString &error) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        error = QString("Can't open %1: %2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+    QTextStream stream(&file);
+    stream << m_size << "\n";
+    for (int row = 0; row < m_size; ++row) {
+        for (int col = 0; col < m_size; ++col) {
+            if (col > 0)
+                stream << ' ';
+            if (row == col)
+                stream << 'X';
+            else
+                stream << qint64(distance(row, col)); // All generated distances are integers
+        }
+        stream << "\n";
+    }
+    return true;
+}
+
+bool InstanceGenerator::typeFromName(const QString &name, Type &type)
+{
+    const QStringList names = typeNames();
+    const int index = names.indexOf(name.toLower());
+    if (index < 0)
+        return false;
+    type = Type(index);
+    return true;
+}
+
+QString InstanceGenerator::typeName(const Type type)
+{
+    return typeNames().value(int(type));
+}
+
+QStringList InstanceGenerator::typeNames()
+{
+    return {"uniform", "euclidean", "clustered", "road", "planted"};
+}
+
+quint64 InstanceGenerator::splitMix(quint64 x)
+{
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+quint64 InstanceGenerator::cellHash(const int row, const int col) const
+{
+    return splitMix(m_seed ^ splitMix((quint64(quint32(row)) << 32) | quint32(col)));
+}
+
+double InstanceGenerator::cellRandom(const int row, const int col) const
+{
+    return toUnit(cellHash(row, col));
+}
+
+quint64 InstanceGenerator::nextRandom(quint64 &state)
+{
+    const quint64 result = splitMix(state);
+    state += 0x9e3779b97f4a7c15ull;
+    return result;
+}
+
+double InstanceGenerator::toUnit(const quint64 hash)
+{
+    return double(hash >> 11) * (1.0 / 9007199254740992.0); // 53 bit mantissa
+}
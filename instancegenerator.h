@@ -0,0 +1,75 @@
+#ifndef INSTANCEGENERATOR_H
+#define INSTANCEGENERATOR_H
+
+#include <QVector>
+#include <QPointF>
+#include <QString>
+#include <QStringList>
+
+// Reproducible test instances. Every distance depends only on (seed, row, col)
+// and the per-city data generated from the seed, so the same instance can be
+// written straight into the solver matrix or streamed row by row into a file.
+// All random values come from SplitMix64, never from <random>, so a seed gives
+// the same instance with every compiler and standard library.
+//
+//   UNIFORM   - independent integer distances in [1, maxDistance]
+//   EUCLIDEAN - rounded distances (at least 1) between uniform random points
+//   CLUSTERED - euclidean, points are grouped around random centers
+//   ROAD      - euclidean with independent detour factor for each direction
+//   PLANTED   - random tour with distances in [1, maxDistance / 2], every other
+//               edge in (maxDistance / 2, maxDistance], so the tour is the optimum
+class InstanceGenerator
+{
+public:
+    enum class Type : int {
+        UNIFORM,
+        EUCLIDEAN,
+        CLUSTERED,
+        ROAD,
+        PLANTED
+    };
+
+    InstanceGenerator(const Type type, const int size, const quint64 seed, const int maxDistance = 1000);
+
+    Type type() const { return m_type; }
+    int size() const { return m_size; }
+    quint64 seed() const { return m_seed; }
+
+    // -1 on the diagonal
+    float distance(const int row, const int col) const;
+    // Fills solver (column-major) matrix
+    void fillMatrix(QVector<float> &mat) const;
+    // Same format as MatrixIO, without building the matrix in memory
+    bool writeMatrix(const QString &fileName, QString &error) const;
+
+    // Only for Type::PLANTED
+    const QVector<int> &plantedTour() const { return m_plantedTour; }
+    float plantedLength() const { return m_plantedLength; }
+
+    static bool typeFromName(const QString &name, Type &type);
+    static QString typeName(const Type type);
+    static QStringList typeNames();
+
+private:
+    static quint64 splitMix(quint64 x);
+    quint64 cellHash(const int row, const int col) const;
+    // Uniform in [0, 1)
+    double cellRandom(const int row, const int col) const;
+    // Next value of the per-city data stream
+    static quint64 nextRandom(quint64 &state);
+    // Uniform in [0, 1) from the high 53 bits
+    static double toUnit(const quint64 hash);
+
+private:
+    Type m_type = Type::UNIFORM;
+    int m_size = 0;
+    quint64 m_seed = 0;
+    int m_maxDistance = 1000;
+
+    QVector<QPointF> m_points;
+    QVector<int> m_plantedNext;
+    QVector<int> m_plantedTour;
+    float m_plantedLength = 0.f;
+};
+
+#endif // INSTANCEGENERATOR_H
@@ -1,9 +1,13 @@
 #include "mainwindow.h"
+#include "headless.h"
 
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    if (Headless::isHeadless(argc, argv))
+        return Headless::run(argc, argv);
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
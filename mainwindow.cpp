@@ -2,9 +2,18 @@
 #include "ui_mainwindow.h"
 
 #include <QDebug>
+#include <QAction>
+#include <QActionGroup>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QMenu>
 #include <QMessageBox>
+#include <QPushButton>
+#include <QStatusBar>
+#include <QTreeView>
+#include <QVBoxLayout>
 
-#include <chrono>
 #include <limits>
 #include <algorithm>
 
@@ -23,8 +32,33 @@ MainWindow::MainWindow(QWidget *parent)
     ui->frame_Answer->hide();
 
     menuBar()->addAction("Load test data", this, &MainWindow::loadTestData);
-    menuBar()->addAction("Random input", this, &MainWindow::randomInput);
-    std::srand(std::time(nullptr));
+    QMenu *randomMenu = menuBar()->addMenu("Random input");
+    const QStringList typeNames = InstanceGenerator::typeNames();
+    for (int t = 0; t < typeNames.size(); ++t) {
+        const InstanceGenerator::Type type = InstanceGenerator::Type(t);
+        randomMenu->addAction(typeNames[t], this, [this, type]() { randomInput(type); });
+    }
+    QAction *presolveAction = menuBar()->addAction("Presolve");
+    presolveAction->setCheckable(true);
+    connect(presolveAction, &QAction::toggled, this, [this](const bool checked) { m_solver.setPresolve(checked); });
+    QMenu *branchingMenu = menuBar()->addMenu("Branching");
+    QActionGroup *branchingGroup = new QActionGroup(branchingMenu);
+    const QStringList branchingNames = BranchingStrategy::typeNames();
+    for (int b = 0; b < branchingNames.size(); ++b) {
+        const BranchingStrategy::Type type = BranchingStrategy::Type(b);
+        QAction *action = branchingMenu->addAction(branchingNames[b], this, [this, type]() { m_solver.setBranching(type); });
+        action->setCheckable(true);
+        action->setChecked(type == m_solver.branching());
+        branchingGroup->addAction(action);
+    }
+    createSearchTreeTab();
+
+    // Live estimate of branch and bound: computing blocks the event loop, so the status bar is repainted directly
+    m_solver.setEstimator(&m_estimator);
+    m_solver.setProgressCallback([this](const SearchEstimator::Estimate &estimate) {
+        statusBar()->showMessage(TspSolver::getEstimateString(estimate));
+        statusBar()->repaint();
+    });
 }
 
 MainWindow::~MainWindow()
@@ -66,8 +100,14 @@ void MainWindow::checkInsertedItem(QTableWidgetItem *item)
         item->setText("X");
         return;
     }
+    // "X" or a negative value: there is no path between these cities
+    const QString text = item->text().trimmed();
     bool isOk = true;
-    const float value = item->text().toFloat(&isOk);
+    const float value = text.toFloat(&isOk);
+    if (text.compare("X", Qt::CaseInsensitive) == 0 || (isOk && value < 0.f)) {
+        item->setText("X");
+        return;
+    }
     isOk = (value > 0.f) && isOk;
     if (!isOk)
         item->setText("0");
@@ -75,275 +115,20 @@ void MainWindow::checkInsertedItem(QTableWidgetItem *item)
         item->setText(QString::number(value));
 }
 
-QString MainWindow::getConvertedTime(const size_t timeInNs)
-{
-    const size_t timeInMs = timeInNs / 1000000ull;
-    const size_t timeInSeconds = timeInMs / 1000;
-    const size_t timeInMinutes = timeInSeconds / 60;
-    const size_t timeInHours = timeInMinutes / 60;
-    const size_t ns = timeInNs % 1000000ull;
-    const size_t ms = timeInMs % 1000;
-    const size_t sec = timeInSeconds % 60;
-    const size_t min = timeInMinutes % 60;
-    const size_t hrs = timeInHours;
-
-    QString result;
-    if (hrs > 0)
-        result += QString::number(hrs) + "h, ";
-    if (min > 0)
-        result += QString::number(min) + "min, ";
-    if (sec > 0)
-        result += QString::number(sec) + "sec, ";
-    if (ms > 0)
-        result += QString::number(ms) + "ms, ";
-    result += QString::number(ns) + "ns";
-
-    return result;
-}
-
 void MainWindow::fillMatrix(QVector<float> &mat, QTableWidget *table)
 {
     const int size = table->columnCount();
     for (int col = 0; col < size; ++col)
         for (int row = 0; row < size; ++row) {
             if (row == col) {
-                get(mat, size, row, col) = -1.f;
-                continue;
-            }
-
-            get(mat, size, row, col) = table->item(row, col)->text().toFloat();
-        }
-}
-
-QString MainWindow::getMatrixString(const QVector<float> &mat, const int size)
-{
-    const int floatPrecision = 3;
-    const int valueWith = 10;
-    QString result;
-    result += QString("   ");
-    for (int col = 0; col < size; ++col)
-        result += QString("%1 ").arg(col, valueWith);
-    result += "\n";
-    for (int row = 0; row < size; ++row) {
-        result += QString("%1|").arg(row, 3);
-        for (int col = 0; col < size; ++col) {
-            if (get(mat, size, row, col) < 0.f) {
-                result += QString("%1 ").arg("X", valueWith);
-                continue;
-            }
-
-            result += QString("%1 ").arg(get(mat, size, row, col), valueWith, 'g', floatPrecision);
-        }
-        result += QString("|\n");
-    }
-    return result;
-}
-
-QString MainWindow::getRouteString(const QVector<QPoint> &route)
-{
-    QString result;
-    const int size = route.size();
-    result += "{";
-    if (size == 0) {
-        result += "Empty}\n";
-        return result;
-    }
-    for (int i = 0; i < size - 1; ++i)
-        result += QString("%1->%2, ").arg(route[i].x()).arg(route[i].y());
-    result += QString("%1->%2}\n").arg(route[size-1].x()).arg(route[size-1].y());
-    return result;
-}
-
-void MainWindow::sortRoute(QVector<QPoint> &route) // TODO
-{
-    const int size = route.size();
-    for (int i = 0; i < size; ++i) { // Start from 0 city
-        if (route[i].x() == 0) {
-            std::swap(route[0], route[i]);
-            break;
-        }
-    }
-    for (int left = 0; left < size - 1; ++left) {
-        for (int i = left + 1; i < size; ++i) {
-            if (route[left].y() == route[i].x()) {
-                std::swap(route[left + 1], route[i]);
-                break;
-            }
-        }
-    }
-}
-
-int MainWindow::randomInt(const int max)
-{
-    return std::rand() % max + 1;
-}
-
-bool MainWindow::findPivotZero(
-        const QVector<float> &mat,
-        const int size,
-        QPoint &zeroPos,
-        float &score)
-{
-    QVector<float> rowScore(size, 0);
-    QVector<float> colScore(size, 0);
-
-    // fillRowScore
-    for (int row = 0; row < size; ++row) {
-        float minValue = std::numeric_limits<float>::max();
-        bool hasZero = false;
-        for (int col = 0; col < size; ++col) {
-            const float value = get(mat, size, row, col);
-            if (value < 0.f)
-                continue;
-
-            if (!hasZero && qFuzzyIsNull(value)) {
-                hasZero = true;
-                continue;
-            }
-
-            if (value < minValue)
-                minValue = value;
-        }
-        if (minValue == std::numeric_limits<float>::max())
-            minValue = 0.f;
-        rowScore[row] = minValue;
-    }
-
-    // fillColScore
-    for (int col = 0; col < size; ++col) {
-        float minValue = std::numeric_limits<float>::max();
-        bool hasZero = false;
-        for (int row = 0; row < size; ++row) {
-            const float value = get(mat, size, row, col);
-            if (value < 0.f)
+                TspSolver::get(mat, size, row, col) = -1.f;
                 continue;
-
-            if (!hasZero && qFuzzyIsNull(value)) {
-                hasZero = true;
-                continue;
-            }
-
-            if (value < minValue)
-                minValue = value;
-        }
-        if (minValue == std::numeric_limits<float>::max())
-            minValue = 0.f;
-        colScore[col] = minValue;
-    }
-
-    float bestScore = -1.f;
-    QPoint resPos = QPoint(0, 0);
-    for (int col = 0; col < size; ++col)
-        for (int row = 0; row < size; ++row) {
-            const float value = get(mat, size, row, col);
-            if (qFuzzyIsNull(value)) {
-                const float score = rowScore[row] + colScore[col];
-                if (score > bestScore) {
-                    bestScore = score;
-                    resPos = QPoint(row, col);
-                }
-            }
-        }
-
-    zeroPos = resPos;
-    score = bestScore;
-
-    if (bestScore < 0.f)
-        return false;
-
-    return true;
-}
-
-QVector<float> MainWindow::matWithIncludedPath(
-        const QVector<float> &oldMat,
-        const int size,
-        const QPoint &newPath,
-        const QVector<QPoint> &currentRoute)
-{
-    QVector<float> mat = oldMat;
-    for (int row = 0; row < size; ++row){
-        get(mat, size, row, newPath.y()) = -1;
-    }
-    for (int col = 0; col < size; ++col){
-        get(mat, size, newPath.x(), col) = -1;
-    }
-
-    const int nRoutes = currentRoute.size();
-    if (nRoutes == size - 2) // Не удаляем подцикл если следующтй путь последний
-        return mat;
-    int beginCurrentPath = newPath.x();
-    int endCurrentPath = newPath.y();
-    bool done = false;
-    while (!done) {// Удаляем подциклы
-        done = true;
-        for (int r = 0; r < nRoutes; ++r) {
-            const int endPartPath = currentRoute[r].y();
-            if (beginCurrentPath == endPartPath) {
-                beginCurrentPath = currentRoute[r].x();
-                done = false;
-                break;
             }
-        }
-        for (int r = 0; r < nRoutes; ++r) {
-            const int beginPartPath = currentRoute[r].x();
-            if (endCurrentPath == beginPartPath) {
-                endCurrentPath = currentRoute[r].y();
-                done = false;
-                break;
-            }
-        }
-    }
-    get(mat, size, endCurrentPath, beginCurrentPath) = -1;
-    return mat;
-}
-
-float MainWindow::simplifyMatrix(QVector<float> &mat, const int size)
-{
-    float result = 0.f;
-    for (int row = 0; row < size; ++row) {
-        float minValue = std::numeric_limits<float>::max();
-        for (int col = 0; col < size; ++col) {
-            float &value = get(mat, size, row, col);
-            if (value < 0.f)
-                continue;
-            if (value < minValue)
-                minValue = value;
-        }
-
-        if (minValue == std::numeric_limits<float>::max())
-            continue;
-        for (int col = 0; col < size; ++col) {
-            float &value = get(mat, size, row, col);
-            if (value < 0.f)
-                continue;
-
-            value -= minValue;
-        }
-        result += minValue;
-    }
-
-    for (int col = 0; col < size; ++col) {
-        float minValue = std::numeric_limits<float>::max();
-        for (int row = 0; row < size; ++row) {
-            float &value = get(mat, size, row, col);
-            if (value < 0.f)
-                continue;
-            if (value < minValue)
-                minValue = value;
-        }
-
-        if (minValue == std::numeric_limits<float>::max())
-            continue;
-        for (int row = 0; row < size; ++row) {
-            float &value = get(mat, size, row, col);
-            if (value < 0.f)
-                continue;
 
-            value -= minValue;
+            bool isOk = true;
+            const float value = table->item(row, col)->text().toFloat(&isOk);
+            TspSolver::get(mat, size, row, col) = isOk ? value : -1.f;
         }
-        result += minValue;
-    }
-    return result;
 }
 
 void MainWindow::clearLog()
@@ -377,266 +162,64 @@ void MainWindow::showLog()
     ui->textBrowser_log->setText(m_logText[index]);
 }
 
-void MainWindow::calcNode(
-        const QVector<float> &inputMat,
-        const int size,
-        const QVector<QPoint> &currentRoute,
-        const float beforeSimplifyRating, // Оценка текущей ноды до приведения
-        float &bestRating,
-        QVector<QVector<QPoint>> &bestRoute,
-        const bool needToSimplify,
-        const AnswerType answerType)
+void MainWindow::showResult(const TspSolver::Result &result, const QString &finishMessage, const QString &title)
 {
     addLog("\n");
     addLog("\n");
-    addLog("Текущий маршрут:");
-    addLog(getRouteString(currentRoute));
-    //qDebug() << getRouteString(currentRoute);
-    addLog("Текущая матрица:\n");
-    addLog(getMatrixString(inputMat, size));
-    QVector<float> mat = inputMat;
-    float simplifyRating = simplifyMatrix(mat, size);
-    if (!needToSimplify)
-        simplifyRating = 0.f;
-    const float currentRating = simplifyRating + beforeSimplifyRating;
-    if (simplifyRating > 0.f) {
-        addLog("Приведёная матрица:\n");
-        addLog(getMatrixString(mat, size));
-        addLog(QString("Оценка после приведения: %1 + %2 = %3\n").arg(beforeSimplifyRating).arg(simplifyRating).arg(currentRating));
-    }
-    else {
-        if (needToSimplify)
-            addLog(QString("Матрица уже приведёная, оценка не изменилась: %1\n").arg(currentRating));
-        else
-            addLog(QString("При исключении пути приведение не требуется, оценка не изменилась: %1\n").arg(currentRating));
-    }
-    const bool hasRecord = (bestRating != std::numeric_limits<float>::max());
-    if (hasRecord) { // Если уже есть рекорд
-        if (answerType == AnswerType::FIRST && bestRating <= currentRating) {
-            addLog(QString("Оценка хуже или равна текущему рекорду: %1 <= %2; Закрытие ветки.\n").arg(bestRating).arg(currentRating));
-            return;
-        }
-        else if (answerType == AnswerType::ALL && bestRating < currentRating) {
-            addLog(QString("Оценка хуже текущего рекорда: %1 < %2; Закрытие ветки.\n").arg(bestRating).arg(currentRating));
-            return;
-        }
-    }
-
-    QPoint zeroPos;
-    float score = 0.f;
-    const bool isFounded = findPivotZero(mat, size, zeroPos, score);
-    if (!isFounded) {
-        const bool isAnswer = currentRoute.size() == size;
-        if (!isAnswer) {
-            addLog("Доступные пути кончились, решение не получено; Закрытие ветки.\n");
-            return;
-        }
-        if (answerType == AnswerType::FIRST && bestRating > currentRating) {
-            addLog(QString("Новый рекорд: %1; Рекордный путь: %2").arg(currentRating).arg(getRouteString(currentRoute)));
-            bestRating = currentRating;
-            bestRoute = {currentRoute};
-        }
-        else if (answerType == AnswerType::ALL && bestRating >= currentRating) {
-            const bool newRecord = bestRating > currentRating;
-            if (newRecord) {
-                addLog(QString("Новый рекорд: %1; Рекордный путь: %2").arg(currentRating).arg(getRouteString(currentRoute)));
-                bestRating = currentRating;
-                bestRoute = {currentRoute};
-            }
-            else {
-                addLog(QString("Получен старый рекорд: %1; Добавлен путь: %2").arg(currentRating).arg(getRouteString(currentRoute)));
-                bestRating = currentRating;
-                bestRoute.push_back(currentRoute);
-            }
-        }
-        else {
-            addLog(QString("Получено решение: %1; Полученый путь: %2").arg(currentRating).arg(getRouteString(currentRoute)));
-            addLog(QString("Полученное решение хуже или равно текущему рекорду: %1 <= %2; Закрытие ветки.\n").arg(bestRating).arg(currentRating));
-        }
-        return;
-    }
-    addLog(QString("Включаем в маршрут путь %1->%2\n").arg(zeroPos.x()).arg(zeroPos.y()));
-    QVector<QPoint> newRoute = currentRoute;
-    newRoute.push_back(zeroPos);
-    const QVector<float> newMat = matWithIncludedPath(
-                mat,
-                size,
-                zeroPos,
-                currentRoute);
-    calcNode(newMat, size, newRoute, currentRating, bestRating, bestRoute, true, answerType);
-    addLog("\n");
-    addLog("\n");
-    addLog("Возврат к маршруту:");
-    addLog(getRouteString(currentRoute));
-    const float secondRating = currentRating + score;
-    addLog(QString("Исключаем из маршрута путь %1->%2; Оценка после исключения: %3 + %4 = %5\n").arg(zeroPos.x()).arg(zeroPos.y()).arg(currentRating).arg(score).arg(secondRating));
-    const bool hasRecordNow = (bestRating != std::numeric_limits<float>::max());
-    if (hasRecordNow) { // Если уже есть рекорд
-        if (answerType == AnswerType::FIRST && bestRating <= secondRating) {
-            addLog(QString("Оценка хуже или равна текущему рекорду: %1 <= %2; Закрытие ветки.\n").arg(bestRating).arg(secondRating));
-            return;
-        }
-        else if (answerType == AnswerType::ALL && bestRating < secondRating) {
-            addLog(QString("Оценка хуже текущего рекорда: %1 < %2; Закрытие ветки.\n").arg(bestRating).arg(secondRating));
-            return;
-        }
-    }
-    get(mat, size, zeroPos.x(), zeroPos.y()) = -1;
-    calcNode(mat, size, currentRoute, secondRating, bestRating, bestRoute, false, answerType);
-}
-
-void MainWindow::bruteForceCalc(
-        const QVector<float> &mat,
-        const int size,
-        const QVector<int> &route,
-        const float prevScore,
-        float &bestRating,
-        QVector<QVector<QPoint>> &bestRoutes,
-        const AnswerType answerType)
-{
-    const int iter = route.size();
-    if (iter == size) {
-        if (answerType == AnswerType::FIRST && prevScore < bestRating) {
-            QVector<QPoint> checkRoute(size);
-            for (int i = 0; i < size; ++i)
-                checkRoute[i] = QPoint(i, route[i]);
-            int hop = 0;
-            int nHops = 0;
-            bool endLoop = false;
-            while (!endLoop){
-                hop = route[hop];
-                ++nHops;
-                if (hop == 0)
-                    endLoop = true;
-            }
-            bool isRealRecord = (nHops == size);
-            if (isRealRecord) {
-                bestRating = prevScore;
-                bestRoutes = {checkRoute};
-
-                addLog(QString("Новый рекорд: %1; Рекордный путь: %2").arg(bestRating).arg(getRouteString(bestRoutes[0])));
-            }
-            else
-                addLog(QString("Полученный путь не является замкнутым; Закрытие ветки.\n"));
-        }
-        else if (answerType == AnswerType::ALL && prevScore <= bestRating) {
-            QVector<QPoint> checkRoute(size);
-            for (int i = 0; i < size; ++i)
-                checkRoute[i] = QPoint(i, route[i]);
-            int hop = 0;
-            int nHops = 0;
-            bool endLoop = false;
-            while (!endLoop){
-                hop = route[hop];
-                ++nHops;
-                if (hop == 0)
-                    endLoop = true;
-            }
-            bool isRealRecord = (nHops == size);
-            if (isRealRecord) {
-                const bool newRecord = prevScore < bestRating;
-                if (newRecord) {
-                    bestRating = prevScore;
-                    bestRoutes = {checkRoute};
-                    addLog(QString("Новый рекорд: %1; Рекордный путь: %2").arg(bestRating).arg(getRouteString(bestRoutes[0])));
-                }
-                else {
-                    bestRating = prevScore;
-                    bestRoutes.push_back(checkRoute);
-                    addLog(QString("Получен старый рекорд: %1; Добавлен путь: %2").arg(bestRating).arg(getRouteString(bestRoutes[0])));
-                }
-            }
-            else
-                addLog(QString("Полученный путь не является замкнутым; Закрытие ветки.\n"));
-        }
-        return;
-    }
-
-    for (int i = 0; i < size; ++i) {
-        if (iter == i)
-            continue;
-        const bool isVisited = std::find(route.begin(), route.end(), i) != route.end();
-        if (isVisited)
-            continue;
-
-        const float newScore = prevScore + get(mat, size, iter, i);
-        const bool hasRecord = (bestRating != std::numeric_limits<float>::max());
-
-        QVector<int> newRoute = route;
-        newRoute.push_back(i);
-        QVector<QPoint> currRoute(newRoute.size());
-        for (int i = 0; i < newRoute.size(); ++i)
-            currRoute[i] = QPoint(i, newRoute[i]);
-        addLog(QString("Текущая длина: %1; Текущий путь: %2").arg(newScore).arg(getRouteString(currRoute)));
-        if (hasRecord) {
-            if (answerType == AnswerType::FIRST && bestRating <= newScore) {
-                addLog(QString("Выбранный путь хуже или равен текущему рекорду: %1 <= %2; Закрытие ветки.\n").arg(bestRating).arg(newScore));
-                continue;
-            }
-            else if (answerType == AnswerType::ALL && bestRating < newScore) {
-                addLog(QString("Выбранный путь хуже текущего рекорда: %1 < %2; Закрытие ветки.\n").arg(bestRating).arg(newScore));
-                continue;
-            }
-        }
-        bruteForceCalc(mat, size, newRoute, newScore, bestRating, bestRoutes, answerType);
-    }
-}
-
-void MainWindow::on_pushButton_compute_clicked()
-{
-    clearLog();
-    ui->label_Answer->setText("Computing...");
-
-    QVector<float> mat(m_nCities * m_nCities);
-    fillMatrix(mat, ui->tableWidget_inputMatrix);
-
-    addLog("Входная матрица:\n");
-    addLog(getMatrixString(mat, m_nCities));
-    float bestRating = std::numeric_limits<float>::max();
-    QVector<QVector<QPoint>> bestRoutes;
-    const std::chrono::system_clock::time_point startTime = std::chrono::system_clock::now();
-    calcNode(mat, m_nCities, QVector<QPoint>(), 0.f, bestRating, bestRoutes, true, m_answerType);
-    const std::chrono::system_clock::time_point endTime = std::chrono::system_clock::now();
-    const size_t timeInNs = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
-    addLog("\n");
-    addLog("\n");
-    addLog("Обход дерева окончен\n");
+    addLog(finishMessage + "\n");
+    const QVector<Tour> &bestRoutes = result.routes;
     const int nRoutes = bestRoutes.size();
-    for (int r = 0; r < nRoutes; ++r)
-        sortRoute(bestRoutes[r]);
     if (nRoutes == 1)
-        addLog(QString("Лучший маршрут: " + getRouteString(bestRoutes[0])));
+        addLog(QString("Лучший маршрут: " + bestRoutes[0].toString()));
     else {
         addLog(QString("Лучшие маршруты (%1):\n").arg(nRoutes));
         for (int r = 0; r < nRoutes; ++r)
-            addLog(QString("  " + getRouteString(bestRoutes[r])));
+            addLog(QString("  " + bestRoutes[r].toString()));
     }
-    addLog(QString("Длина маршрута: %1\n").arg(bestRating));
+    addLog(QString("Длина маршрута: %1\n").arg(result.length));
     showLog();
     QString answer = "";
     if (nRoutes == 1)
-        answer += "Best route = " + getRouteString(bestRoutes[0]);
+        answer += "Best route = " + bestRoutes[0].toString();
     else {
         answer += "Best routes (" + QString::number(nRoutes) + "):\n";
-        for (int r = 0; r < nRoutes; ++r) {
-            //TEST
-            //float sum = 0.f;
-            //for (int i = 0; i < bestRoutes[r].size(); ++i) {
-            //    const QPoint &node = bestRoutes[r][i];
-            //    sum += get(mat, m_nCities, node.x(), node.y());
-            //}
-            //answer += QString::number(sum) + ":";
-            //
-            answer += getRouteString(bestRoutes[r]);
-        }
+        for (int r = 0; r < nRoutes; ++r)
+            answer += bestRoutes[r].toString();
     }
-    answer += QString("Length = %1\n").arg(bestRating);
-    answer += QString("Time = %1").arg(getConvertedTime(timeInNs));
+    answer += QString("Length = %1\n").arg(result.length);
+    answer += QString("Time = %1").arg(TspSolver::getConvertedTime(result.timeInNs));
+    if (result.nodes > 0)
+        answer += QString("\nBranching = %1, nodes = %2").arg(BranchingStrategy::typeName(result.branching)).arg(result.nodes);
+    if (result.estimate.totalNodes > 0.)
+        answer += QString(" (estimated ~%1)").arg(result.estimate.totalNodes, 0, 'g', 3);
+    if (result.presolve.isDone)
+        answer += QString("\nPresolve: removed %1/%2, fixed %3")
+                .arg(result.presolve.nRemoved).arg(result.presolve.nEdges).arg(result.presolve.nFixed);
     ui->label_Answer->setText(answer);
-    ui->label_AnswerTitle->setText("Answer (branch and bound)");
+    ui->label_AnswerTitle->setText(title);
     ui->frame_Answer->show();
 }
 
+void MainWindow::on_pushButton_compute_clicked()
+{
+    clearLog();
+    ui->label_Answer->setText("Computing...");
+
+    QVector<float> mat(m_nCities * m_nCities);
+    fillMatrix(mat, ui->tableWidget_inputMatrix);
+
+    addLog("Входная матрица:\n");
+    addLog(TspSolver::getMatrixString(mat, m_nCities));
+    m_solver.setLogger([this](const QString &string) { addLog(string); });
+    m_searchTreeModel->setTrace(nullptr);
+    m_solver.setTrace(m_traceCheckBox->isChecked() ? &m_trace : nullptr);
+    const TspSolver::Result result = m_solver.solveBranchAndBound(mat, m_nCities, m_answerType);
+    m_solver.setTrace(nullptr);
+    if (m_traceCheckBox->isChecked())
+        m_searchTreeModel->setTrace(&m_trace);
+    showResult(result, "Обход дерева окончен", "Answer (branch and bound)");
+}
+
 void MainWindow::on_spinBox_logPage_valueChanged(int arg1)
 {
     Q_UNUSED(arg1);
@@ -656,116 +239,125 @@ void MainWindow::on_pushButton_clicked()
     fillMatrix(mat, ui->tableWidget_inputMatrix);
 
     addLog("Входная матрица:\n");
-    addLog(getMatrixString(mat, m_nCities));
-    float bestRating = std::numeric_limits<float>::max();
-    QVector<QVector<QPoint>> bestRoutes;
-    const std::chrono::system_clock::time_point startTime = std::chrono::system_clock::now();
-    bruteForceCalc(mat, m_nCities, {}, 0.f, bestRating, bestRoutes, m_answerType);
-    const std::chrono::system_clock::time_point endTime = std::chrono::system_clock::now();
-    const size_t timeInNs = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
-    addLog("\n");
-    addLog("\n");
-    addLog("Полный перебор окончен\n");
-    const int nRoutes = bestRoutes.size();
-    for (int r = 0; r < nRoutes; ++r)
-        sortRoute(bestRoutes[r]);
-    if (nRoutes == 1)
-        addLog(QString("Лучший маршрут: " + getRouteString(bestRoutes[0])));
-    else {
-        addLog(QString("Лучшие маршруты (%1):\n").arg(nRoutes));
-        for (int r = 0; r < nRoutes; ++r)
-            addLog(QString("  " + getRouteString(bestRoutes[r])));
-    }
-    addLog(QString("Длина маршрута: %1\n").arg(bestRating));
-    showLog();
-    QString answer = "";
-    if (nRoutes == 1)
-        answer += "Best route = " + getRouteString(bestRoutes[0]);
-    else {
-        answer += "Best routes (" + QString::number(nRoutes) + "):\n";
-        for (int r = 0; r < nRoutes; ++r) {
-            //TEST
-            //float sum = 0.f;
-            //for (int i = 0; i < bestRoutes[r].size(); ++i) {
-            //    const QPoint &node = bestRoutes[r][i];
-            //    sum += get(mat, m_nCities, node.x(), node.y());
-            //}
-            //answer += QString::number(sum) + ":";
-            //
-            answer += getRouteString(bestRoutes[r]);
-        }
-    }
-    answer += QString("Length = %1\n").arg(bestRating);
-    answer += QString("Time = %1").arg(getConvertedTime(timeInNs));
-    ui->label_Answer->setText(answer);
-    ui->label_AnswerTitle->setText("Answer (brute force)");
-    ui->frame_Answer->show();
+    addLog(TspSolver::getMatrixString(mat, m_nCities));
+    m_solver.setLogger([this](const QString &string) { addLog(string); });
+    const TspSolver::Result result = m_solver.solveBruteForce(mat, m_nCities, m_answerType);
+    showResult(result, "Полный перебор окончен", "Answer (brute force)");
 }
 
 void MainWindow::loadTestData()
 {
     ui->spinBox_nCities->setValue(6);
     QVector<float> mat(6 * 6);
-    get(mat, 6, 0, 0) = -1;
-    get(mat, 6, 1, 0) = 4;
-    get(mat, 6, 2, 0) = 5;
-    get(mat, 6, 3, 0) = 2;
-    get(mat, 6, 4, 0) = 4;
-    get(mat, 6, 5, 0) = 3;
-
-    get(mat, 6, 0, 1) = 6;
-    get(mat, 6, 1, 1) = -1;
-    get(mat, 6, 2, 1) = 4;
-    get(mat, 6, 3, 1) = 3;
-    get(mat, 6, 4, 1) = 6;
-    get(mat, 6, 5, 1) = 2;
-
-    get(mat, 6, 0, 2) = 3;
-    get(mat, 6, 1, 2) = 3;
-    get(mat, 6, 2, 2) = -1;
-    get(mat, 6, 3, 2) = 4;
-    get(mat, 6, 4, 2) = 6;
-    get(mat, 6, 5, 2) = 4;
-
-    get(mat, 6, 0, 3) = 5;
-    get(mat, 6, 1, 3) = 4;
-    get(mat, 6, 2, 3) = 4;
-    get(mat, 6, 3, 3) = -1;
-    get(mat, 6, 4, 3) = 7;
-    get(mat, 6, 5, 3) = 3;
-
-    get(mat, 6, 0, 4) = 4;
-    get(mat, 6, 1, 4) = 2;
-    get(mat, 6, 2, 4) = 3;
-    get(mat, 6, 3, 4) = 5;
-    get(mat, 6, 4, 4) = -1;
-    get(mat, 6, 5, 4) = 5;
-
-    get(mat, 6, 0, 5) = 2;
-    get(mat, 6, 1, 5) = 3;
-    get(mat, 6, 2, 5) = 2;
-    get(mat, 6, 3, 5) = 6;
-    get(mat, 6, 4, 5) = 5;
-    get(mat, 6, 5, 5) = -1;
+    TspSolver::get(mat, 6, 0, 0) = -1;
+    TspSolver::get(mat, 6, 1, 0) = 4;
+    TspSolver::get(mat, 6, 2, 0) = 5;
+    TspSolver::get(mat, 6, 3, 0) = 2;
+    TspSolver::get(mat, 6, 4, 0) = 4;
+    TspSolver::get(mat, 6, 5, 0) = 3;
+
+    TspSolver::get(mat, 6, 0, 1) = 6;
+    TspSolver::get(mat, 6, 1, 1) = -1;
+    TspSolver::get(mat, 6, 2, 1) = 4;
+    TspSolver::get(mat, 6, 3, 1) = 3;
+    TspSolver::get(mat, 6, 4, 1) = 6;
+    TspSolver::get(mat, 6, 5, 1) = 2;
+
+    TspSolver::get(mat, 6, 0, 2) = 3;
+    TspSolver::get(mat, 6, 1, 2) = 3;
+    TspSolver::get(mat, 6, 2, 2) = -1;
+    TspSolver::get(mat, 6, 3, 2) = 4;
+    TspSolver::get(mat, 6, 4, 2) = 6;
+    TspSolver::get(mat, 6, 5, 2) = 4;
+
+    TspSolver::get(mat, 6, 0, 3) = 5;
+    TspSolver::get(mat, 6, 1, 3) = 4;
+    TspSolver::get(mat, 6, 2, 3) = 4;
+    TspSolver::get(mat, 6, 3, 3) = -1;
+    TspSolver::get(mat, 6, 4, 3) = 7;
+    TspSolver::get(mat, 6, 5, 3) = 3;
+
+    TspSolver::get(mat, 6, 0, 4) = 4;
+    TspSolver::get(mat, 6, 1, 4) = 2;
+    TspSolver::get(mat, 6, 2, 4) = 3;
+    TspSolver::get(mat, 6, 3, 4) = 5;
+    TspSolver::get(mat, 6, 4, 4) = -1;
+    TspSolver::get(mat, 6, 5, 4) = 5;
+
+    TspSolver::get(mat, 6, 0, 5) = 2;
+    TspSolver::get(mat, 6, 1, 5) = 3;
+    TspSolver::get(mat, 6, 2, 5) = 2;
+    TspSolver::get(mat, 6, 3, 5) = 6;
+    TspSolver::get(mat, 6, 4, 5) = 5;
+    TspSolver::get(mat, 6, 5, 5) = -1;
 
     for (int col = 0; col < 6; ++col)
         for (int row = 0; row < 6; ++row) {
             if (row == col)
                 continue;
 
-            ui->tableWidget_inputMatrix->setItem(row, col, new QTableWidgetItem(QString::number(get(mat, 6, row, col))));
+            ui->tableWidget_inputMatrix->setItem(row, col, new QTableWidgetItem(QString::number(TspSolver::get(mat, 6, row, col))));
         }
 }
 
-void MainWindow::randomInput()
+void MainWindow::randomInput(const InstanceGenerator::Type type)
 {
+    const quint64 seed = ++m_randomSeed;
+    const InstanceGenerator generator(type, m_nCities, seed, 100);
     for (int col = 0; col < m_nCities; ++col)
         for (int row = 0; row < m_nCities; ++row) {
             if (row == col)
                 continue;
 
-            ui->tableWidget_inputMatrix->setItem(row, col, new QTableWidgetItem(QString::number(randomInt(10))));
+            ui->tableWidget_inputMatrix->setItem(row, col, new QTableWidgetItem(QString::number(generator.distance(row, col))));
         }
+    statusBar()->showMessage(QString("Random input: %1, seed %2").arg(InstanceGenerator::typeName(type)).arg(seed));
+}
+
+void MainWindow::createSearchTreeTab()
+{
+    QWidget *tab = new QWidget(ui->tabWidget);
+    QVBoxLayout *layout = new QVBoxLayout(tab);
+    QHBoxLayout *buttonsLayout = new QHBoxLayout();
+    m_traceCheckBox = new QCheckBox("Record search tree", tab);
+    QPushButton *chromeTraceButton = new QPushButton("Export Chrome trace...", tab);
+    QPushButton *collapsedStacksButton = new QPushButton("Export collapsed stacks...", tab);
+    buttonsLayout->addWidget(m_traceCheckBox);
+    buttonsLayout->addStretch();
+    buttonsLayout->addWidget(chromeTraceButton);
+    buttonsLayout->addWidget(collapsedStacksButton);
+    layout->addLayout(buttonsLayout);
+
+    m_searchTreeModel = new SearchTreeModel(this);
+    QTreeView *view = new QTreeView(tab);
+    view->setUniformRowHeights(true); // Keeps long expanded branches cheap
+    view->setModel(m_searchTreeModel);
+    view->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    layout->addWidget(view);
+    ui->tabWidget->addTab(tab, "Search tree");
+
+    connect(chromeTraceButton, &QPushButton::clicked, this, [this]() { exportTrace(true); });
+    connect(collapsedStacksButton, &QPushButton::clicked, this, [this]() { exportTrace(false); });
+}
+
+void MainWindow::exportTrace(const bool isChromeTrace)
+{
+    if (m_trace.isEmpty()) {
+        QMessageBox::information(this, "Search tree", "Nothing recorded: check \"Record search tree\" and compute first.");
+        return;
+    }
+    const QString fileName = isChromeTrace
+            ? QFileDialog::getSaveFileName(this, "Export Chrome trace", "trace.json", "Chrome trace (*.json)")
+            : QFileDialog::getSaveFileName(this, "Export collapsed stacks", "stacks.txt", "Collapsed stacks (*.txt)");
+    if (fileName.isEmpty())
+        return;
+    QString error;
+    const bool isOk = isChromeTrace ? m_trace.writeChromeTrace(fileName, error) : m_trace.writeCollapsedStacks(fileName, error);
+    if (!isOk) {
+        QMessageBox::warning(this, "Search tree", error);
+        return;
+    }
+    statusBar()->showMessage(QString("Exported %1 nodes%2").arg(m_trace.size()).arg(m_trace.isTruncated() ? " (truncated)" : ""));
 }
 
 void MainWindow::on_pushButton_clearInput_clicked()
@@ -3,18 +3,17 @@
 
 #include <QMainWindow>
 
+#include <QCheckBox>
 #include <QTableWidget>
 #include <QVector>
 #include <QPoint>
 #include <QString>
 
-#include <cstdlib>
-#include <ctime>
-
-enum class AnswerType : int {
-    FIRST,
-    ALL
-};
+#include "instancegenerator.h"
+#include "searchestimator.h"
+#include "searchtrace.h"
+#include "searchtreemodel.h"
+#include "tspsolver.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -40,7 +39,6 @@ private slots:
     void on_pushButton_clicked();
 
     void loadTestData();
-    void randomInput();
     void on_pushButton_clearInput_clicked();
     void on_comboBox_AnswerType_currentIndexChanged(int index);
 
@@ -49,53 +47,28 @@ private:
     void checkInsertedItem(QTableWidgetItem *item);
 
     // Routine functions
-    template<class T>
-    static inline T &get(QVector<T>& mat, const int size, const int row, const int col) { return mat[row + col * size]; }
-    template<class T>
-    static inline float get(const QVector<T>& mat, const int size, const int row, const int col) { return mat[row + col * size]; }
-    static QString getConvertedTime(const size_t timeInNs);
     static void fillMatrix(QVector<float>& mat, QTableWidget *table);
-    static QString getMatrixString(const QVector<float>& mat, const int size);
-    static QString getRouteString(const QVector<QPoint>& route);
-    static void sortRoute(QVector<QPoint>& route);
-    static int randomInt(const int max);
-    bool findPivotZero(const QVector<float>& mat, const int size, QPoint &zeroPos, float &score);
-    QVector<float> matWithIncludedPath(
-            const QVector<float>& oldMat,
-            const int size,
-            const QPoint &newPath,
-            const QVector<QPoint> &currentRoute);
-    float simplifyMatrix(QVector<float>& mat, const int size);
-
+    // Fills table with generated instance of the next seed
+    void randomInput(const InstanceGenerator::Type type);
+    // "Search tree" tab: recorded branch and bound tree and its export
+    void createSearchTreeTab();
+    void exportTrace(const bool isChromeTrace);
 
     void clearLog();
     void addLog(const QString &string);
     void showLog();
-
-    // Recursive branch and bound
-    void calcNode(
-            const QVector<float> &mat,
-            const int size,
-            const QVector<QPoint> &currentRoute,
-            const float topNodeRating,
-            float &bestRating,
-            QVector<QVector<QPoint>> &bestRoute,
-            const bool needToSimplify,
-            const AnswerType answerType);
-
-    // Recursive bruteforce
-    void bruteForceCalc(
-            const QVector<float> &mat,
-            const int size,
-            const QVector<int> &route,
-            const float prevScore,
-            float &bestRating,
-            QVector<QVector<QPoint>> &bestRoutes,
-            const AnswerType answerType);
+    // Shows solver result in log and answer frame
+    void showResult(const TspSolver::Result &result, const QString &finishMessage, const QString &title);
 
 private:
     int m_nCities = 2;
+    quint64 m_randomSeed = 0;
     AnswerType m_answerType = AnswerType(0);
+    TspSolver m_solver;
+    SearchEstimator m_estimator;
+    SearchTrace m_trace;
+    SearchTreeModel *m_searchTreeModel = nullptr;
+    QCheckBox *m_traceCheckBox = nullptr;
 
     QVector<QString> m_logText;
     int m_lineCounter = 0;
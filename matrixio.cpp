@@ -0,0 +1,159 @@
+#include "matrixio.h"
+
+#include "tspsolver.h"
+
+bool MatrixIO::readMatrix(const QString &fileName, QVector<float> &mat, int &size, QString &error)
+{
+    QFile file(fileName);
+    QTextStream stream;
+    QString token;
+    if (!readHeader(file, stream, fileName, size, token, error))
+        return false;
+    if (token == edgeListTag()) {
+        SparseGraph graph;
+        if (!readEdges(stream, fileName, size, graph, error))
+            return false;
+        graph.fillMatrix(mat);
+        return true;
+    }
+
+    mat.resize(size * size);
+    for (int row = 0; row < size; ++row)
+        for (int col = 0; col < size; ++col)
+            if (!readValue(stream, fileName, size, row, col, token, TspSolver::get(mat, size, row, col), error))
+                return false;
+    return true;
+}
+
+bool MatrixIO::writeMatrix(const QString &fileName, const QVector<float> &mat, const int size, QString &error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        error = QString("Can't open %1: %2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+    QTextStream stream(&file);
+    stream << size << "\n";
+    for (int row = 0; row < size; ++row) {
+        for (int col = 0; col < size; ++col) {
+            if (col > 0)
+                stream << ' ';
+            const float value = TspSolver::get(mat, size, row, col);
+            if (value < 0.f)
+                stream << 'X';
+            else
+                stream << value;
+        }
+        stream << "\n";
+    }
+    return true;
+}
+
+bool MatrixIO::readGraph(const QString &fileName, SparseGraph &graph, QString &error)
+{
+    QFile file(fileName);
+    QTextStream stream;
+    QString token;
+    int size = 0;
+    if (!readHeader(file, stream, fileName, size, token, error))
+        return false;
+    if (token == edgeListTag())
+        return readEdges(stream, fileName, size, graph, error);
+
+    // Edges straight from the values, the matrix is never built
+    QVector<SparseGraph::Edge> edges;
+    for (int row = 0; row < size; ++row)
+        for (int col = 0; col < size; ++col) {
+            float value = -1.f;
+            if (!readValue(stream, fileName, size, row, col, token, value, error))
+                return false;
+            if (value >= 0.f)
+                edges.push_back({row, col, value});
+        }
+    graph = SparseGraph(size, edges);
+    return true;
+}
+
+bool MatrixIO::writeGraph(const QString &fileName, const SparseGraph &graph, QString &error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        error = QString("Can't open %1: %2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+    QTextStream stream(&file);
+    stream << graph.size() << ' ' << edgeListTag() << "\n";
+    for (int edge = 0; edge < graph.edgeCount(); ++edge)
+        stream << graph.from(edge) << ' ' << graph.to(edge) << ' ' << graph.weights()[edge] << "\n";
+    return true;
+}
+
+bool MatrixIO::readHeader(QFile &file, QTextStream &stream, const QString &fileName, int &size, QString &token, QString &error)
+{
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        error = QString("Can't open %1: %2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+    stream.setDevice(&file);
+    stream >> token;
+    bool isOk = true;
+    const qint64 fileSize = token.toLongLong(&isOk);
+    if (!isOk || fileSize < 2 || fileSize > TspSolver::maxSize) {
+        error = QString("%1: bad number of cities \"%2\", expected 2 to %3").arg(fileName).arg(token).arg(TspSolver::maxSize);
+        return false;
+    }
+    size = int(fileSize);
+    stream >> token;
+    return true;
+}
+
+bool MatrixIO::readEdges(QTextStream &stream, const QString &fileName, const int size, SparseGraph &graph, QString &error)
+{
+    QVector<SparseGraph::Edge> edges;
+    QString fromToken;
+    QString toToken;
+    QString weightToken;
+    while (true) {
+        stream >> fromToken;
+        if (fromToken.isEmpty())
+            break;
+        stream >> toToken >> weightToken;
+        SparseGraph::Edge edge;
+        bool isFromOk = false;
+        bool isToOk = false;
+        bool isWeightOk = false;
+        edge.from = fromToken.toInt(&isFromOk);
+        edge.to = toToken.toInt(&isToOk);
+        edge.weight = weightToken.toFloat(&isWeightOk);
+        if (!isFromOk || !isToOk || !isWeightOk || edge.from < 0 || edge.from >= size || edge.to < 0 || edge.to >= size) {
+            error = QString("%1: bad edge \"%2 %3 %4\"").arg(fileName).arg(fromToken).arg(toToken).arg(weightToken);
+            return false;
+        }
+        edges.push_back(edge);
+    }
+    graph = SparseGraph(size, edges);
+    return true;
+}
+
+bool MatrixIO::readValue(QTextStream &stream, const QString &fileName, const int size, const int row, const int col, QString &token, float &value, QString &error)
+{
+    if (row != 0 || col != 0)
+        stream >> token;
+    if (token.isEmpty()) {
+        error = QString("%1: expected %2 values").arg(fileName).arg(qint64(size) * size);
+        return false;
+    }
+    if (row == col || token == "X" || token == "x") {
+        value = -1.f;
+        return true;
+    }
+    bool isOk = true;
+    value = token.toFloat(&isOk);
+    if (!isOk) {
+        error = QString("%1: bad value \"%2\" at %3,%4").arg(fileName).arg(token).arg(row).arg(col);
+        return false;
+    }
+    if (value < 0.f)
+        value = -1.f;
+    return true;
+}
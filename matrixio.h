@@ -0,0 +1,34 @@
+#ifndef MATRIXIO_H
+#define MATRIXIO_H
+
+#include <QFile>
+#include <QVector>
+#include <QString>
+#include <QTextStream>
+
+#include "sparsegraph.h"
+
+// Text matrix files: first token is the number of cities (2 to TspSolver::maxSize), then size * size
+// row-major values. "X" or a negative value means "no edge".
+// Edge list files: the number of cities followed by "edges", then one
+// "from to weight" line per edge, cities are numbered from 0.
+// Both read functions take both formats.
+class MatrixIO
+{
+public:
+    static bool readMatrix(const QString &fileName, QVector<float> &mat, int &size, QString &error);
+    static bool writeMatrix(const QString &fileName, const QVector<float> &mat, const int size, QString &error);
+    // Matrix files become a graph of their non-negative values
+    static bool readGraph(const QString &fileName, SparseGraph &graph, QString &error);
+    static bool writeGraph(const QString &fileName, const SparseGraph &graph, QString &error);
+
+private:
+    static QString edgeListTag() { return "edges"; }
+    // Opens fileName and reads the header, the first token after the number of cities stays in token
+    static bool readHeader(QFile &file, QTextStream &stream, const QString &fileName, int &size, QString &token, QString &error);
+    static bool readEdges(QTextStream &stream, const QString &fileName, const int size, SparseGraph &graph, QString &error);
+    // Next matrix value, -1 for "no edge"; token already holds the value of the first cell
+    static bool readValue(QTextStream &stream, const QString &fileName, const int size, const int row, const int col, QString &token, float &value, QString &error);
+};
+
+#endif // MATRIXIO_H
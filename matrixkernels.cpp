@@ -0,0 +1,192 @@
+#include "matrixkernels.h"
+
+#include <QSemaphore>
+#include <QVector>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <limits>
+
+#ifdef Q_OS_LINUX
+#include <sys/mman.h>
+#endif
+
+float MatrixKernels::reduce(float *mat, const int size)
+{
+    const float noValue = std::numeric_limits<float>::max();
+    // Warm per-thread buffers, chunk threads get plain pointers to them
+    thread_local QVector<float> rowMinBuffer;
+    thread_local QVector<float> colMinBuffer;
+    rowMinBuffer.resize(size);
+    colMinBuffer.resize(size);
+    float *rowMin = rowMinBuffer.data();
+    float *colMin = colMinBuffer.data();
+
+    // Row minimums
+    parallelFor(size, [&](const int begin, const int end) {
+        for (int block = begin; block < end; block += blockRows) {
+            const int blockEnd = qMin(end, block + blockRows);
+            std::fill(rowMin + block, rowMin + blockEnd, noValue);
+            for (int col = 0; col < size; ++col) {
+                const float *column = mat + size_t(col) * size_t(size);
+                for (int row = block; row < blockEnd; ++row) {
+                    const float value = column[row];
+                    if (value >= 0.f && value < rowMin[row])
+                        rowMin[row] = value;
+                }
+            }
+        }
+    });
+
+    float result = 0.f;
+    for (int row = 0; row < size; ++row) {
+        if (rowMin[row] == noValue)
+            rowMin[row] = 0.f; // Empty row, nothing to subtract
+        else
+            result += rowMin[row];
+    }
+
+    // Row subtraction fused with the column pass, every column is contiguous
+    parallelFor(size, [&](const int begin, const int end) {
+        for (int col = begin; col < end; ++col) {
+            float *column = mat + size_t(col) * size_t(size);
+            float minValue = noValue;
+            for (int row = 0; row < size; ++row) {
+                float &value = column[row];
+                if (value < 0.f)
+                    continue;
+                value -= rowMin[row];
+                if (value < minValue)
+                    minValue = value;
+            }
+            colMin[col] = minValue;
+            if (minValue == noValue)
+                continue;
+            for (int row = 0; row < size; ++row) {
+                float &value = column[row];
+                if (value < 0.f)
+                    continue;
+                value -= minValue;
+            }
+        }
+    });
+
+    for (int col = 0; col < size; ++col)
+        if (colMin[col] != noValue)
+            result += colMin[col];
+    return result;
+}
+
+void MatrixKernels::penalties(const float *mat, const int size, float *rowPenalty, float *colPenalty)
+{
+    const float noValue = std::numeric_limits<float>::max();
+    thread_local QVector<char> hasZeroBuffer;
+    hasZeroBuffer.resize(size);
+    char *rowHasZero = hasZeroBuffer.data();
+
+    parallelFor(size, [&](const int begin, const int end) {
+        for (int block = begin; block < end; block += blockRows) {
+            const int blockEnd = qMin(end, block + blockRows);
+            std::fill(rowPenalty + block, rowPenalty + blockEnd, noValue);
+            std::fill(rowHasZero + block, rowHasZero + blockEnd, char(0));
+            for (int col = 0; col < size; ++col) {
+                const float *column = mat + size_t(col) * size_t(size);
+                for (int row = block; row < blockEnd; ++row) {
+                    const float value = column[row];
+                    if (value < 0.f)
+                        continue;
+                    if (!rowHasZero[row] && qFuzzyIsNull(value)) { // The first zero is the one to be excluded
+                        rowHasZero[row] = 1;
+                        continue;
+                    }
+                    if (value < rowPenalty[row])
+                        rowPenalty[row] = value;
+                }
+            }
+            for (int row = block; row < blockEnd; ++row)
+                if (rowPenalty[row] == noValue)
+                    rowPenalty[row] = 0.f;
+        }
+    });
+
+    parallelFor(size, [&](const int begin, const int end) {
+        for (int col = begin; col < end; ++col) {
+            const float *column = mat + size_t(col) * size_t(size);
+            float minValue = noValue;
+            bool hasZero = false;
+            for (int row = 0; row < size; ++row) {
+                const float value = column[row];
+                if (value < 0.f)
+                    continue;
+                if (!hasZero && qFuzzyIsNull(value)) {
+                    hasZero = true;
+                    continue;
+                }
+                if (value < minValue)
+                    minValue = value;
+            }
+            colPenalty[col] = minValue == noValue ? 0.f : minValue;
+        }
+    });
+}
+
+void MatrixKernels::transpose(const float *mat, const int size, float *transposed)
+{
+    parallelFor(size, [&](const int begin, const int end) {
+        for (int colBlock = begin; colBlock < end; colBlock += transposeBlock) {
+            const int colBlockEnd = qMin(end, colBlock + transposeBlock);
+            for (int rowBlock = 0; rowBlock < size; rowBlock += transposeBlock) {
+                const int rowBlockEnd = qMin(size, rowBlock + transposeBlock);
+                for (int col = colBlock; col < colBlockEnd; ++col)
+                    for (int row = rowBlock; row < rowBlockEnd; ++row)
+                        transposed[size_t(row) * size_t(size) + size_t(col)] = mat[size_t(col) * size_t(size) + size_t(row)];
+            }
+        }
+    });
+}
+
+void MatrixKernels::adviseHugePages(void *data, const size_t bytes)
+{
+#ifdef Q_OS_LINUX
+    const quintptr hugePage = 2u * 1024u * 1024u;
+    const quintptr begin = (quintptr(data) + hugePage - 1) & ~(hugePage - 1);
+    const quintptr end = (quintptr(data) + bytes) & ~(hugePage - 1);
+    if (end > begin)
+        madvise(reinterpret_cast<void *>(begin), size_t(end - begin), MADV_HUGEPAGE); // Only a hint, failure is fine
+#else
+    Q_UNUSED(data);
+    Q_UNUSED(bytes);
+#endif
+}
+
+void MatrixKernels::parallelFor(const int count, const std::function<void(int, int)> &body)
+{
+    const int nChunks = count < parallelSize ? 1 : qMin(pool()->maxThreadCount(), count / (parallelSize / 4));
+    if (nChunks <= 1) {
+        body(0, count);
+        return;
+    }
+
+    const auto chunkBegin = [count, nChunks](const int chunk) {
+        if (chunk == nChunks)
+            return count;
+        return int(qint64(count) * chunk / nChunks) & ~15;
+    };
+    QSemaphore done;
+    for (int chunk = 1; chunk < nChunks; ++chunk) {
+        const int begin = chunkBegin(chunk);
+        const int end = chunkBegin(chunk + 1);
+        pool()->start([&body, &done, begin, end]() {
+            body(begin, end);
+            done.release();
+        });
+    }
+    body(0, chunkBegin(1));
+    done.acquire(nChunks - 1);
+}
+
+QThreadPool *MatrixKernels::pool()
+{
+    static QThreadPool kernelPool;
+    return &kernelPool;
+}
@@ -0,0 +1,42 @@
+#ifndef MATRIXKERNELS_H
+#define MATRIXKERNELS_H
+
+#include <QThreadPool>
+
+#include <functional>
+
+// Raw kernels over the column-major solver matrix (see TspSolver::get).
+// Every pass walks memory column by column, row state (minimums, flags) is
+// kept per block of rows small enough for L1, so a row pass is a sequential
+// scan instead of a stride of size floats per element. From parallelSize on
+// blocks are split across the threads of a private pool. Results are bit
+// identical to the plain loops: per-line values are visited in the same
+// order and sums are taken in line order after the parallel part.
+class MatrixKernels
+{
+public:
+    static constexpr int parallelSize = 512;
+
+    // Row then column reduction in place, returns the sum of subtracted minimums
+    static float reduce(float *mat, const int size);
+    // Minimum of every row and column without one of its zeros
+    static void penalties(const float *mat, const int size, float *rowPenalty, float *colPenalty);
+    // Column-major to row-major (and back), blocked so both sides stay in cache
+    static void transpose(const float *mat, const int size, float *transposed);
+
+    // Hints the kernel to back the huge pages lying wholly inside [data, data + bytes) with
+    // transparent huge pages (Linux only). Nothing is allocated or aligned here: with QVector
+    // storage only buffers of at least 4 MB are sure to contain such a page.
+    static void adviseHugePages(void *data, const size_t bytes);
+
+private:
+    static constexpr int blockRows = 4096;
+    static constexpr int transposeBlock = 32;
+
+    // body(begin, end) for chunks of [0, count), chunk borders are multiples of 16 (one cache line of floats)
+    static void parallelFor(const int count, const std::function<void(int, int)> &body);
+    // Own pool: kernels are called from solver threads of the global one
+    static QThreadPool *pool();
+};
+
+#endif // MATRIXKERNELS_H
@@ -0,0 +1,167 @@
+#include "presolve.h"
+
+#include "matrixkernels.h"
+
+#include <chrono>
+#include <limits>
+
+TspSolver::PresolveStatistics Presolve::run(
+        QVector<float> &mat,
+        const int size,
+        const AnswerType answerType,
+        QVector<QPoint> &fixedRoute,
+        Tour &heuristicTour)
+{
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    TspSolver::PresolveStatistics statistics;
+    statistics.isDone = true;
+    statistics.nEdges = countEdges(mat, size);
+    statistics.upperBound = nearestNeighbourTour(mat, size, heuristicTour);
+    const bool hasUpperBound = !heuristicTour.isEmpty();
+    // Removal must not depend on float rounding of the bound
+    const float tolerance = hasUpperBound ? Presolve::tolerance(statistics.upperBound) : 0.f;
+
+    fixedRoute.clear();
+    float fixedRating = 0.f;
+    QVector<bool> isFixedRow(size, false);
+    QVector<bool> isFixedCol(size, false);
+    QVector<float> reduced;
+    QVector<int> rowPaths;
+    QVector<int> colPaths;
+    QVector<int> rowOther;
+    QVector<int> colOther;
+    bool isChanged = true;
+    bool isFeasible = true;
+    while (isChanged && isFeasible && fixedRoute.size() < size) {
+        isChanged = false;
+
+        // Reduced cost rule
+        reduced = mat;
+        statistics.lowerBound = fixedRating + TspSolver::simplifyMatrix(reduced, size);
+        if (hasUpperBound) {
+            for (int col = 0; col < size; ++col)
+                for (int row = 0; row < size; ++row) {
+                    float &value = TspSolver::get(mat, size, row, col);
+                    if (value < 0.f)
+                        continue;
+                    const float rating = statistics.lowerBound + TspSolver::get(reduced, size, row, col);
+                    if (TspSolver::isWorseThanRecord(rating - tolerance, statistics.upperBound, answerType)) {
+                        value = -1.f;
+                        ++statistics.nRemoved;
+                        isChanged = true;
+                    }
+                }
+        }
+
+        // Single successor / predecessor rule, paths of all cities counted in one column sweep
+        rowPaths.fill(0, size);
+        colPaths.fill(0, size);
+        rowOther.fill(-1, size);
+        colOther.fill(-1, size);
+        for (int col = 0; col < size; ++col)
+            for (int row = 0; row < size; ++row) {
+                if (TspSolver::get(mat, size, row, col) < 0.f)
+                    continue;
+                ++rowPaths[row];
+                rowOther[row] = col;
+                ++colPaths[col];
+                colOther[col] = row;
+            }
+        for (int city = 0; city < size && isFeasible; ++city) {
+            for (int pass = 0; pass < 2; ++pass) {
+                const bool isRow = (pass == 0);
+                if ((isRow && isFixedRow[city]) || (!isRow && isFixedCol[city]))
+                    continue;
+                const int nPaths = isRow ? rowPaths[city] : colPaths[city];
+                if (nPaths == 0) { // No tour (better than the heuristic one) at all
+                    isFeasible = false;
+                    statistics.isExhausted = true;
+                    break;
+                }
+                if (nPaths > 1)
+                    continue;
+
+                const QPoint path = isRow ? QPoint(city, rowOther[city]) : QPoint(colOther[city], city);
+                // Counts are from the sweep: an earlier fix this pass may have taken the path or its city
+                if (isFixedRow[path.x()] || isFixedCol[path.y()] || TspSolver::get(mat, size, path.x(), path.y()) < 0.f)
+                    continue;
+                fixedRating += TspSolver::get(mat, size, path.x(), path.y());
+                TspSolver::includePath(mat, size, path, fixedRoute);
+                fixedRoute.push_back(path);
+                isFixedRow[path.x()] = true;
+                isFixedCol[path.y()] = true;
+                ++statistics.nFixed;
+                isChanged = true;
+            }
+        }
+    }
+
+    statistics.timeInNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+    return statistics;
+}
+
+float Presolve::nearestNeighbourTour(const QVector<float> &mat, const int size, Tour &tour)
+{
+    const int nStarts = qMin(size, 16);
+    float bestRating = std::numeric_limits<float>::max();
+    QVector<int> bestCities;
+    QVector<int> startCities;
+    // Row-major copy: every step scans one row of mat
+    QVector<float> rows(size * size);
+    MatrixKernels::transpose(mat.constData(), size, rows.data());
+    for (int s = 0; s < nStarts; ++s) {
+        const float rating = nearestNeighbourTour(rows, size, s * size / nStarts, startCities);
+        if (!startCities.isEmpty() && rating < bestRating) {
+            bestRating = rating;
+            bestCities = startCities;
+        }
+    }
+    tour = Tour::fromCities(bestCities);
+    return bestRating;
+}
+
+float Presolve::nearestNeighbourTour(const QVector<float> &rows, const int size, const int start, QVector<int> &cities)
+{
+    cities.clear();
+    cities.reserve(size);
+    cities.push_back(start);
+    QVector<bool> isVisited(size, false);
+    isVisited[start] = true;
+    float rating = 0.f;
+    int current = start;
+    for (int step = 1; step < size; ++step) {
+        const float *row = rows.constData() + size_t(current) * size_t(size);
+        int next = -1;
+        for (int col = 0; col < size; ++col) {
+            const float value = row[col];
+            if (isVisited[col] || value < 0.f)
+                continue;
+            if (next < 0 || value < row[next])
+                next = col;
+        }
+        if (next < 0) {
+            cities.clear();
+            return std::numeric_limits<float>::max();
+        }
+        rating += row[next];
+        cities.push_back(next);
+        isVisited[next] = true;
+        current = next;
+    }
+    const float closing = rows[current * size + start];
+    if (closing < 0.f) {
+        cities.clear();
+        return std::numeric_limits<float>::max();
+    }
+    return rating + closing;
+}
+
+int Presolve::countEdges(const QVector<float> &mat, const int size)
+{
+    int nEdges = 0;
+    for (int col = 0; col < size; ++col)
+        for (int row = 0; row < size; ++row)
+            if (row != col && TspSolver::get(mat, size, row, col) >= 0.f)
+                ++nEdges;
+    return nEdges;
+}
@@ -0,0 +1,38 @@
+#ifndef PRESOLVE_H
+#define PRESOLVE_H
+
+#include <QVector>
+#include <QPoint>
+
+#include "tspsolver.h"
+
+// Shrinks the problem before branch and bound:
+//  - reduced costs of the root bound against a nearest neighbour tour remove
+//    every path that can not be in a better tour (or equal for AnswerType::ALL)
+//  - a city with a single possible successor or predecessor fixes that path
+// Both rules are repeated while they change something.
+class Presolve
+{
+public:
+    // mat gets removed paths as -1 and fixed paths included (see TspSolver::includePath).
+    // fixedRoute receives fixed paths in inclusion order, heuristicTour the nearest
+    // neighbour tour (empty if none was found).
+    static TspSolver::PresolveStatistics run(
+            QVector<float> &mat,
+            const int size,
+            const AnswerType answerType,
+            QVector<QPoint> &fixedRoute,
+            Tour &heuristicTour);
+
+    // Rounding allowance of a bound against upperBound: branch and bound sums a tour in another order
+    static float tolerance(const float upperBound) { return 1e-5f * qMax(1.f, qAbs(upperBound)); }
+    // Best nearest neighbour tour over several start cities, returns its length
+    static float nearestNeighbourTour(const QVector<float> &mat, const int size, Tour &tour);
+
+private:
+    // rows is the row-major (transposed) matrix, cities receives the tour from start
+    static float nearestNeighbourTour(const QVector<float> &rows, const int size, const int start, QVector<int> &cities);
+    static int countEdges(const QVector<float> &mat, const int size);
+};
+
+#endif // PRESOLVE_H
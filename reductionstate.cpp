@@ -0,0 +1,312 @@
+#include "reductionstate.h"
+
+#include "matrixkernels.h"
+#include "tspsolver.h"
+
+#include <algorithm>
+
+template<class T>
+static void copyVector(QVector<T> &to, const QVector<T> &from)
+{
+    to.resize(from.size());
+    std::copy(from.constBegin(), from.constEnd(), to.begin());
+}
+
+float ReductionState::reset(QVector<float> &mat, const int size)
+{
+    const float result = MatrixKernels::reduce(mat.data(), size);
+    m_size = size;
+    m_rowZeros.fill(0, size);
+    m_colZeros.fill(0, size);
+    m_rowFirst.fill(-1, size);
+    m_colFirst.fill(-1, size);
+    m_rowMin.fill(noValue, size);
+    m_colMin.fill(noValue, size);
+    m_isRowDirty.fill(0, size);
+    m_isColDirty.fill(0, size);
+    m_zeros.clear();
+    m_changes.clear();
+    for (int col = 0; col < size; ++col) {
+        const float *column = mat.constData() + size_t(col) * size_t(size);
+        for (int row = 0; row < size; ++row) {
+            const float value = column[row];
+            if (value < 0.f)
+                continue;
+            if (value == 0.f) {
+                ++m_rowZeros[row];
+                ++m_colZeros[col];
+            }
+            const bool isZero = qFuzzyIsNull(value);
+            if (isZero)
+                m_zeros.push_back(row + col * size);
+            if (isZero && m_rowFirst[row] < 0)
+                m_rowFirst[row] = col;
+            else if (value < m_rowMin[row])
+                m_rowMin[row] = value;
+            if (isZero && m_colFirst[col] < 0)
+                m_colFirst[col] = row;
+            else if (value < m_colMin[col])
+                m_colMin[col] = value;
+        }
+    }
+    return result;
+}
+
+void ReductionState::copyFrom(const ReductionState &other)
+{
+    m_size = other.m_size;
+    copyVector(m_rowZeros, other.m_rowZeros);
+    copyVector(m_colZeros, other.m_colZeros);
+    copyVector(m_rowFirst, other.m_rowFirst);
+    copyVector(m_colFirst, other.m_colFirst);
+    copyVector(m_rowMin, other.m_rowMin);
+    copyVector(m_colMin, other.m_colMin);
+    copyVector(m_zeros, other.m_zeros);
+    m_isRowDirty.resize(m_size);
+    m_isColDirty.resize(m_size);
+    m_changes.clear();
+}
+
+float ReductionState::includePath(QVector<float> &mat, const QPoint &path, const QPoint &subtourPath)
+{
+    for (int row = 0; row < m_size; ++row)
+        removeCell(mat, row, path.y());
+    for (int col = 0; col < m_size; ++col)
+        removeCell(mat, path.x(), col);
+    if (subtourPath.x() >= 0)
+        removeCell(mat, subtourPath.x(), subtourPath.y());
+    const float result = reduceTouched(mat);
+    finishUpdate(mat);
+    return result;
+}
+
+float ReductionState::excludePath(QVector<float> &mat, const QPoint &path)
+{
+    removeCell(mat, path.x(), path.y());
+    const float result = reduceTouched(mat);
+    finishUpdate(mat);
+    return result;
+}
+
+void ReductionState::restore(QVector<float> &mat)
+{
+    for (int i = m_changes.size() - 1; i >= 0; --i)
+        mat[m_changes[i].cell] = m_changes[i].value;
+    m_changes.clear();
+}
+
+bool ReductionState::findPivotZero(QPoint &zeroPos, float &score) const
+{
+    float bestScore = -1.f;
+    int bestCell = 0;
+    for (const int cell : m_zeros) {
+        const float cellScore = rowPenalty(cell % m_size) + colPenalty(cell / m_size);
+        if (cellScore > bestScore) {
+            bestScore = cellScore;
+            bestCell = cell;
+        }
+    }
+    zeroPos = QPoint(bestCell % m_size, bestCell / m_size);
+    score = bestScore;
+    return bestScore >= 0.f;
+}
+
+void ReductionState::removeCell(QVector<float> &mat, const int row, const int col)
+{
+    float &value = TspSolver::get(mat, m_size, row, col);
+    const float old = value;
+    if (old < 0.f)
+        return;
+    m_changes.push_back({row + col * m_size, old});
+    value = -1.f;
+    changeRowCell(row, col, old, -1.f);
+    changeColCell(col, row, old, -1.f);
+}
+
+void ReductionState::changeRowCell(const int row, const int col, const float old, const float value)
+{
+    if (old == 0.f && value != 0.f) {
+        if (--m_rowZeros[row] == 0)
+            m_touchedRows.push_back(row);
+    }
+    else if (old != 0.f && value == 0.f)
+        ++m_rowZeros[row];
+
+    if (m_isRowDirty[row])
+        return;
+    if (value < 0.f) { // Removed: only the first zero and the minimum matter
+        if (col == m_rowFirst[row] || old <= m_rowMin[row])
+            markRowDirty(row);
+        return;
+    }
+    if (col == m_rowFirst[row]) // Smaller, still the first zero
+        return;
+    if (qFuzzyIsNull(value) && (m_rowFirst[row] < 0 || col < m_rowFirst[row])) { // New first zero
+        markRowDirty(row);
+        return;
+    }
+    m_rowMin[row] = qMin(m_rowMin[row], value);
+}
+
+void ReductionState::changeColCell(const int col, const int row, const float old, const float value)
+{
+    if (old == 0.f && value != 0.f) {
+        if (--m_colZeros[col] == 0)
+            m_touchedCols.push_back(col);
+    }
+    else if (old != 0.f && value == 0.f)
+        ++m_colZeros[col];
+
+    if (m_isColDirty[col])
+        return;
+    if (value < 0.f) {
+        if (row == m_colFirst[col] || old <= m_colMin[col])
+            markColDirty(col);
+        return;
+    }
+    if (row == m_colFirst[col])
+        return;
+    if (qFuzzyIsNull(value) && (m_colFirst[col] < 0 || row < m_colFirst[col])) {
+        markColDirty(col);
+        return;
+    }
+    m_colMin[col] = qMin(m_colMin[col], value);
+}
+
+void ReductionState::markRowDirty(const int row)
+{
+    if (m_isRowDirty[row])
+        return;
+    m_isRowDirty[row] = 1;
+    m_dirtyRows.push_back(row);
+}
+
+void ReductionState::markColDirty(const int col)
+{
+    if (m_isColDirty[col])
+        return;
+    m_isColDirty[col] = 1;
+    m_dirtyCols.push_back(col);
+}
+
+float ReductionState::reduceTouched(QVector<float> &mat)
+{
+    // Every other line still has an exact zero, its minimum is 0 and adds nothing.
+    // Lines are taken in index order, so the sum is the one of MatrixKernels::reduce.
+    const int size = m_size;
+    float result = 0.f;
+    std::sort(m_touchedRows.begin(), m_touchedRows.end());
+    for (const int row : m_touchedRows) {
+        float minValue = noValue;
+        for (int col = 0; col < size; ++col) {
+            const float value = TspSolver::get(mat, size, row, col);
+            if (value >= 0.f && value < minValue)
+                minValue = value;
+        }
+        if (minValue == noValue) // Empty row
+            continue;
+        result += minValue;
+        for (int col = 0; col < size; ++col) {
+            float &value = TspSolver::get(mat, size, row, col);
+            if (value < 0.f)
+                continue;
+            const float old = value;
+            m_changes.push_back({row + col * size, old});
+            value -= minValue;
+            if (value == 0.f)
+                ++m_rowZeros[row];
+            if (qFuzzyIsNull(value) && !qFuzzyIsNull(old))
+                m_newZeros.push_back(row + col * size);
+            changeColCell(col, row, old, value);
+        }
+        markRowDirty(row);
+    }
+
+    // Row reductions may have given a touched column a zero again
+    std::sort(m_touchedCols.begin(), m_touchedCols.end());
+    for (const int col : m_touchedCols) {
+        if (m_colZeros[col] > 0)
+            continue;
+        float *column = mat.data() + size_t(col) * size_t(size);
+        float minValue = noValue;
+        for (int row = 0; row < size; ++row) {
+            const float value = column[row];
+            if (value >= 0.f && value < minValue)
+                minValue = value;
+        }
+        if (minValue == noValue)
+            continue;
+        result += minValue;
+        for (int row = 0; row < size; ++row) {
+            float &value = column[row];
+            if (value < 0.f)
+                continue;
+            const float old = value;
+            m_changes.push_back({row + col * size, old});
+            value -= minValue;
+            if (value == 0.f)
+                ++m_colZeros[col];
+            if (qFuzzyIsNull(value) && !qFuzzyIsNull(old))
+                m_newZeros.push_back(row + col * size);
+            changeRowCell(row, col, old, value);
+        }
+        markColDirty(col);
+    }
+    m_touchedRows.clear();
+    m_touchedCols.clear();
+    return result;
+}
+
+void ReductionState::finishUpdate(const QVector<float> &mat)
+{
+    const int size = m_size;
+    for (const int row : m_dirtyRows) {
+        int first = -1;
+        float minValue = noValue;
+        for (int col = 0; col < size; ++col) {
+            const float value = TspSolver::get(mat, size, row, col);
+            if (value < 0.f)
+                continue;
+            if (first < 0 && qFuzzyIsNull(value))
+                first = col;
+            else if (value < minValue)
+                minValue = value;
+        }
+        m_rowFirst[row] = first;
+        m_rowMin[row] = minValue;
+        m_isRowDirty[row] = 0;
+    }
+    for (const int col : m_dirtyCols) {
+        const float *column = mat.constData() + size_t(col) * size_t(size);
+        int first = -1;
+        float minValue = noValue;
+        for (int row = 0; row < size; ++row) {
+            const float value = column[row];
+            if (value < 0.f)
+                continue;
+            if (first < 0 && qFuzzyIsNull(value))
+                first = row;
+            else if (value < minValue)
+                minValue = value;
+        }
+        m_colFirst[col] = first;
+        m_colMin[col] = minValue;
+        m_isColDirty[col] = 0;
+    }
+    m_dirtyRows.clear();
+    m_dirtyCols.clear();
+
+    // Zeros only go away with their cell, new ones come from reduced lines
+    int nKept = 0;
+    for (const int cell : m_zeros)
+        if (mat[cell] >= 0.f)
+            m_zeros[nKept++] = cell;
+    m_zeros.resize(nKept);
+    if (m_newZeros.isEmpty())
+        return;
+    std::sort(m_newZeros.begin(), m_newZeros.end());
+    m_mergedZeros.resize(nKept + m_newZeros.size());
+    std::merge(m_zeros.constBegin(), m_zeros.constEnd(), m_newZeros.constBegin(), m_newZeros.constEnd(), m_mergedZeros.begin());
+    m_zeros.swap(m_mergedZeros);
+    m_newZeros.clear();
+}
@@ -0,0 +1,80 @@
+#ifndef REDUCTIONSTATE_H
+#define REDUCTIONSTATE_H
+
+#include <QPoint>
+#include <QVector>
+
+#include <limits>
+
+// Row and column state of a reduced branch and bound matrix: the exact zeros,
+// the first zero and the minimum of the other values (the penalty) of every
+// line, and all zeros in column-major order. A child node starts from a copy
+// of the state of its parent, changes the matrix of its parent in place and
+// only visits the lines its path touched: lines that lost their last zero are
+// reduced again, lines whose first zero or minimum went away are scanned
+// again. Every changed cell is logged, restore() gives the parent its matrix
+// back. Matrices, bounds and pivots are bit identical to
+// TspSolver::simplifyMatrix and TspSolver::findPivotZero.
+class ReductionState
+{
+public:
+    // Reduces mat like TspSolver::simplifyMatrix and builds the state from scratch, O(size^2)
+    float reset(QVector<float> &mat, const int size);
+    // State of the parent node, the buffers of this one are reused
+    void copyFrom(const ReductionState &other);
+    // mat is the matrix of the state. Include and exclude like TspSolver::includePath
+    // (subtourPath may be (-1, -1)) and branch and bound do, then reduce the matrix again.
+    // Both return what TspSolver::simplifyMatrix would.
+    float includePath(QVector<float> &mat, const QPoint &path, const QPoint &subtourPath);
+    float excludePath(QVector<float> &mat, const QPoint &path);
+    // Undoes the cell changes of includePath or excludePath
+    void restore(QVector<float> &mat);
+
+    // Minimum of the line without its first zero, as in TspSolver::fillPenalties
+    float rowPenalty(const int row) const { return m_rowMin[row] == noValue ? 0.f : m_rowMin[row]; }
+    float colPenalty(const int col) const { return m_colMin[col] == noValue ? 0.f : m_colMin[col]; }
+    // Same zero and score as TspSolver::findPivotZero, O(number of zeros)
+    bool findPivotZero(QPoint &zeroPos, float &score) const;
+
+private:
+    struct CellChange {
+        int cell = 0; // row + col * size
+        float value = 0.f; // Before the change
+    };
+
+    static constexpr float noValue = std::numeric_limits<float>::max();
+
+    // Sets the cell to -1
+    void removeCell(QVector<float> &mat, const int row, const int col);
+    // Value of a cell of the line went from old to value (-1 if removed)
+    void changeRowCell(const int row, const int col, const float old, const float value);
+    void changeColCell(const int col, const int row, const float old, const float value);
+    void markRowDirty(const int row);
+    void markColDirty(const int col);
+    // Rows then columns without a zero, like MatrixKernels::reduce
+    float reduceTouched(QVector<float> &mat);
+    // Scans dirty lines again and merges the new zeros
+    void finishUpdate(const QVector<float> &mat);
+
+    int m_size = 0;
+    QVector<int> m_rowZeros; // Exact zeros of every line, a reduced line without one is empty
+    QVector<int> m_colZeros;
+    QVector<int> m_rowFirst; // First zero (qFuzzyIsNull) of every line, -1 if none
+    QVector<int> m_colFirst;
+    QVector<float> m_rowMin; // Minimum without the first zero, noValue if none
+    QVector<float> m_colMin;
+    QVector<int> m_zeros; // Cells (row + col * size) with a zero, ascending
+    QVector<CellChange> m_changes; // In change order
+
+    // Scratch of an update, empty between updates
+    QVector<char> m_isRowDirty;
+    QVector<char> m_isColDirty;
+    QVector<int> m_dirtyRows;
+    QVector<int> m_dirtyCols;
+    QVector<int> m_touchedRows; // Lines that lost their last exact zero
+    QVector<int> m_touchedCols;
+    QVector<int> m_newZeros;
+    QVector<int> m_mergedZeros;
+};
+
+#endif // REDUCTIONSTATE_H
@@ -0,0 +1,116 @@
+#include "searchestimator.h"
+
+#include <QtGlobal>
+
+void SearchEstimator::clear()
+{
+    m_currentIntervalInNs = m_sampleIntervalInNs;
+    m_random.seed(m_seed);
+    m_incumbent = std::numeric_limits<float>::max();
+    m_probeSum = 0.;
+    m_nProbes = 0;
+    m_lastTotalNodes = 0.;
+    m_probeTimeInNs = 0;
+    m_nextProbeInNs = 0;
+    m_samples.clear();
+    m_estimate = Estimate();
+}
+
+size_t SearchEstimator::probeBudgetInNs(const size_t timeInNs) const
+{
+    const double budget = m_probeShare * double(timeInNs) - double(m_probeTimeInNs);
+    if (budget <= 0. || budget < double(m_nextProbeInNs))
+        return 0;
+    return size_t(budget);
+}
+
+void SearchEstimator::addProbe(const double nodes, const size_t timeInNs)
+{
+    m_probeSum += nodes;
+    ++m_nProbes;
+    m_probeTimeInNs += timeInNs;
+    m_nextProbeInNs = timeInNs;
+}
+
+void SearchEstimator::addAbandonedProbe(const size_t timeInNs)
+{
+    m_probeTimeInNs += timeInNs;
+    m_nextProbeInNs = 2 * timeInNs;
+}
+
+void SearchEstimator::setIncumbent(const float upperBound)
+{
+    if (upperBound >= m_incumbent)
+        return;
+    m_incumbent = upperBound;
+    if (m_nProbes > 0)
+        m_lastTotalNodes = m_probeSum / m_nProbes;
+    m_probeSum = 0.;
+    m_nProbes = 0;
+}
+
+void SearchEstimator::addSample(const Sample &sample)
+{
+    if (m_samples.size() >= maxSamples) {
+        const int nKept = m_samples.size() / 2;
+        for (int i = 0; i < nKept; ++i)
+            m_samples[i] = m_samples[2 * i];
+        m_samples.resize(nKept);
+        m_currentIntervalInNs *= 2;
+    }
+    m_samples.push_back(sample);
+
+    Estimate &estimate = m_estimate;
+    estimate.isDone = true;
+    estimate.nodes = sample.nodes;
+    estimate.timeInNs = sample.timeInNs;
+    estimate.nProbes = m_nProbes;
+    estimate.totalNodes = m_nProbes > 0 ? m_probeSum / m_nProbes : m_lastTotalNodes;
+    estimate.lowerBound = sample.lowerBound;
+    estimate.upperBound = sample.upperBound;
+    estimate.gap = relativeGap(sample);
+    estimate.nodeRemainingInNs = -1;
+    if (sample.nodes > 0 && estimate.totalNodes > double(sample.nodes))
+        estimate.nodeRemainingInNs = qint64((estimate.totalNodes - double(sample.nodes)) * double(sample.timeInNs) / double(sample.nodes));
+    estimate.gapRemainingInNs = gapRemainingInNs(sample, estimate.gap);
+    estimate.remainingInNs = estimate.nodeRemainingInNs >= 0 ? estimate.nodeRemainingInNs : estimate.gapRemainingInNs;
+}
+
+void SearchEstimator::addLastSample(const Sample &sample, const bool isComplete)
+{
+    addSample(sample);
+    if (!isComplete)
+        return;
+    m_estimate.nodeRemainingInNs = 0;
+    m_estimate.gapRemainingInNs = 0;
+    m_estimate.remainingInNs = 0;
+}
+
+qint64 SearchEstimator::gapRemainingInNs(const Sample &sample, const float gap) const
+{
+    if (gap < 0.f)
+        return -1;
+    if (gap == 0.f)
+        return 0;
+    // Oldest sample with an incumbent from the last half of the run
+    for (const Sample &old : m_samples) {
+        if (old.timeInNs >= sample.timeInNs)
+            break;
+        const float oldGap = relativeGap(old);
+        if (old.timeInNs * 2 < sample.timeInNs || oldGap < 0.f)
+            continue;
+        if (oldGap <= gap) // Gap is not closing
+            return -1;
+        const double ratePerNs = double(oldGap - gap) / double(sample.timeInNs - old.timeInNs);
+        return qint64(double(gap) / ratePerNs);
+    }
+    return -1;
+}
+
+float SearchEstimator::relativeGap(const Sample &sample)
+{
+    if (sample.upperBound == std::numeric_limits<float>::max())
+        return -1.f;
+    const float gap = qMax(0.f, sample.upperBound - sample.lowerBound);
+    return gap / qMax(qAbs(sample.upperBound), std::numeric_limits<float>::min());
+}
@@ -0,0 +1,106 @@
+#ifndef SEARCHESTIMATOR_H
+#define SEARCHESTIMATOR_H
+
+#include <QVector>
+
+#include <limits>
+#include <random>
+
+// Online estimate of the branch and bound tree size and of the time left
+// (see TspSolver::setEstimator). Two sources:
+//   - Knuth probes: random dives from the root through the children that
+//     survive pruning against the current incumbent. The sum of the branching
+//     factor products along a dive is an unbiased estimate of the number of
+//     nodes of the tree for that incumbent. Probes made before the last record
+//     saw weaker pruning and are dropped.
+//   - gap trajectory: lower bound (smallest bound of the open nodes) and
+//     incumbent sampled over time, the closing rate of their gap over the last
+//     half of the run is extrapolated to zero.
+// A probe (about size levels of O(size^2) each) starts only when its expected
+// cost fits into the probe share of the run time, and is abandoned when it
+// overruns that budget.
+// Remaining time is the estimated nodes left at the observed node rate. Once
+// the search has spent more nodes than the probes predict (early nodes were
+// pruned by worse incumbents), the gap extrapolation is used instead.
+class SearchEstimator
+{
+public:
+    struct Sample {
+        size_t timeInNs = 0;
+        size_t nodes = 0;
+        float lowerBound = 0.f;
+        float upperBound = std::numeric_limits<float>::max(); // max without incumbent
+    };
+
+    struct Estimate {
+        bool isDone = false; // Estimator was on during the run
+        size_t nodes = 0;
+        size_t timeInNs = 0;
+        int nProbes = 0; // Probes since the last record
+        double totalNodes = 0.; // Mean of the probes, 0 while unknown
+        float lowerBound = 0.f;
+        float upperBound = std::numeric_limits<float>::max();
+        float gap = -1.f; // (upper - lower) / upper, -1 without incumbent
+        qint64 nodeRemainingInNs = -1; // -1 means unknown
+        qint64 gapRemainingInNs = -1;
+        qint64 remainingInNs = -1;
+    };
+
+    static constexpr size_t defaultSampleIntervalInMs = 250;
+    static constexpr double defaultProbeShare = 0.02;
+    static constexpr int maxSamples = 4096;
+
+    SearchEstimator() = default;
+
+    void setSampleIntervalInMs(const size_t intervalInMs) { m_sampleIntervalInNs = intervalInMs * 1000000ull; }
+    // Part of the run time that probes may take
+    void setProbeShare(const double share) { m_probeShare = share; }
+    // Probes of a run are reproducible for the same seed
+    void setSeed(const quint64 seed) { m_seed = seed; }
+    // Called by the solver on every run
+    void clear();
+
+    // Time the next probe may take, 0 while the probe share of timeInNs can't absorb
+    // the cost of the last probe
+    size_t probeBudgetInNs(const size_t timeInNs) const;
+    void addProbe(const double nodes, const size_t timeInNs);
+    // Probe that ran out of its budget, the next one waits for twice the time
+    void addAbandonedProbe(const size_t timeInNs);
+    // 0 or 1 with equal probability, child of a probe
+    int randomChild() { return int(m_random() & 1u); }
+    // Drops probes of a weaker incumbent
+    void setIncumbent(const float upperBound);
+
+    bool isSampleDue(const size_t timeInNs) const { return m_samples.isEmpty() || timeInNs >= m_samples.last().timeInNs + m_currentIntervalInNs; }
+    // Appends to the trajectory and updates estimate()
+    void addSample(const Sample &sample);
+    // Sample at the end of a run, nothing remains if the search is complete
+    void addLastSample(const Sample &sample, const bool isComplete);
+
+    const Estimate &estimate() const { return m_estimate; }
+    // Gap trajectory, thinned to every other sample (and double interval) when full
+    const QVector<Sample> &samples() const { return m_samples; }
+
+private:
+    qint64 gapRemainingInNs(const Sample &sample, const float gap) const;
+    static float relativeGap(const Sample &sample);
+
+private:
+    size_t m_sampleIntervalInNs = defaultSampleIntervalInMs * 1000000ull;
+    size_t m_currentIntervalInNs = 0;
+    double m_probeShare = defaultProbeShare;
+    quint64 m_seed = 1;
+    std::mt19937_64 m_random;
+
+    float m_incumbent = std::numeric_limits<float>::max();
+    double m_probeSum = 0.;
+    int m_nProbes = 0;
+    double m_lastTotalNodes = 0.; // Mean before the last record, kept until a new probe
+    size_t m_probeTimeInNs = 0;
+    size_t m_nextProbeInNs = 0; // Expected cost of the next probe
+
+    QVector<Sample> m_samples;
+    Estimate m_estimate;
+};
+
+#endif // SEARCHESTIMATOR_H
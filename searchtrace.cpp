@@ -0,0 +1,171 @@
+#include "searchtrace.h"
+
+#include <QFile>
+#include <QTextStream>
+
+SearchTrace::SearchTrace(const size_t maxNodes)
+    : m_maxNodes(maxNodes)
+{
+    clear();
+}
+
+void SearchTrace::clear()
+{
+    m_nodes.clear();
+    m_isTruncated = false;
+    m_startTime = std::chrono::steady_clock::now();
+}
+
+quint32 SearchTrace::beginNode(const quint32 parent, const Branch branch, const QPoint &path, const int depth, const float bound)
+{
+    if (m_maxNodes != 0 && size_t(m_nodes.size()) >= m_maxNodes) {
+        m_isTruncated = true;
+        return noNode;
+    }
+    const quint32 id = quint32(m_nodes.size());
+    Node node;
+    node.parent = parent;
+    node.subtreeEnd = id;
+    node.bound = bound;
+    node.from = path.x();
+    node.to = path.y();
+    node.depth = quint32(depth);
+    node.branch = branch;
+    node.startInNs = elapsedInNs();
+    m_nodes.push_back(node);
+
+    if (parent != noNode) {
+        Node &parentNode = m_nodes[int(parent)];
+        if (branch == Branch::INCLUDE)
+            parentNode.includeChild = id;
+        else
+            parentNode.excludeChild = id;
+    }
+    return id;
+}
+
+void SearchTrace::endNode(const quint32 id)
+{
+    Node &node = m_nodes[int(id)];
+    node.subtreeEnd = quint32(m_nodes.size() - 1);
+    node.durationInNs = elapsedInNs() - node.startInNs;
+}
+
+int SearchTrace::childCount(const quint32 id) const
+{
+    const Node &node = m_nodes[int(id)];
+    return int(node.includeChild != noNode) + int(node.excludeChild != noNode);
+}
+
+quint32 SearchTrace::child(const quint32 id, const int index) const
+{
+    const Node &node = m_nodes[int(id)];
+    if (index == 0 && node.includeChild != noNode)
+        return node.includeChild;
+    return node.excludeChild;
+}
+
+quint64 SearchTrace::selfTimeInNs(const quint32 id) const
+{
+    quint64 childrenTime = 0;
+    for (int c = 0; c < childCount(id); ++c)
+        childrenTime += m_nodes[int(child(id, c))].durationInNs;
+    const quint64 duration = m_nodes[int(id)].durationInNs;
+    return duration > childrenTime ? duration - childrenTime : 0;
+}
+
+bool SearchTrace::writeChromeTrace(const QString &fileName, QString &error) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        error = QString("Can't open %1: %2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+    // Written by hand: QJsonDocument would keep millions of events in memory
+    QTextStream stream(&file);
+    stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    for (int id = 0; id < m_nodes.size(); ++id) {
+        const Node &node = m_nodes[id];
+        if (id > 0)
+            stream << ",\n";
+        stream << "{\"name\":\"" << nodeName(node) << "\",\"cat\":\"bnb\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+               << ",\"ts\":" << QString::number(node.startInNs / 1000.0, 'f', 3)
+               << ",\"dur\":" << QString::number(node.durationInNs / 1000.0, 'f', 3)
+               << ",\"args\":{\"id\":" << id
+               << ",\"parent\":" << (node.parent == noNode ? -1 : qint64(node.parent))
+               << ",\"depth\":" << node.depth
+               << ",\"bound\":" << node.bound
+               << ",\"nodes\":" << (node.subtreeEnd - quint32(id) + 1)
+               << ",\"outcome\":\"" << outcomeName(node.outcome) << "\"}}";
+    }
+    stream << "\n]}\n";
+    return true;
+}
+
+bool SearchTrace::writeCollapsedStacks(const QString &fileName, QString &error) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        error = QString("Can't open %1: %2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+    QTextStream stream(&file);
+    // Nodes are in DFS order, so the stack of the current path is enough
+    QVector<quint32> path;
+    QString stack;
+    QVector<int> stackLengths;
+    for (int id = 0; id < m_nodes.size(); ++id) {
+        const Node &node = m_nodes[id];
+        while (!path.isEmpty() && path.last() != node.parent) {
+            path.removeLast();
+            stack.truncate(stackLengths.takeLast());
+        }
+        stackLengths.push_back(stack.size());
+        if (!path.isEmpty())
+            stack += ';';
+        stack += nodeName(node);
+        path.push_back(quint32(id));
+
+        const quint64 selfTime = selfTimeInNs(quint32(id));
+        if (selfTime > 0)
+            stream << stack << ' ' << selfTime << "\n";
+    }
+    return true;
+}
+
+QString SearchTrace::nodeName(const Node &node)
+{
+    switch (node.branch) {
+    case Branch::ROOT:
+        return "root";
+    case Branch::INCLUDE:
+        return QString("+%1->%2").arg(node.from).arg(node.to);
+    case Branch::EXCLUDE:
+        return QString("-%1->%2").arg(node.from).arg(node.to);
+    }
+    return QString();
+}
+
+QString SearchTrace::outcomeName(const Outcome outcome)
+{
+    switch (outcome) {
+    case Outcome::OPEN:
+        return "open";
+    case Outcome::BRANCHED:
+        return "branched";
+    case Outcome::PRUNED:
+        return "pruned";
+    case Outcome::DEAD_END:
+        return "dead end";
+    case Outcome::SOLUTION:
+        return "solution";
+    case Outcome::RECORD:
+        return "record";
+    }
+    return QString();
+}
+
+quint64 SearchTrace::elapsedInNs() const
+{
+    return quint64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_startTime).count());
+}
@@ -0,0 +1,91 @@
+#ifndef SEARCHTRACE_H
+#define SEARCHTRACE_H
+
+#include <QVector>
+#include <QPoint>
+#include <QString>
+
+#include <chrono>
+
+// Recorder of the branch and bound search tree (see TspSolver::setTrace).
+// Nodes are kept in a flat array of fixed-size records in creation (DFS pre-)
+// order, so the subtree of a node is the contiguous range [id, subtreeEnd]
+// and nothing else is allocated per node. Exports:
+//   - Chrome trace JSON (chrome://tracing, Perfetto): one complete event per
+//     node spanning its whole subtree, nested by time into a flame chart
+//   - collapsed stacks ("root;+0->3;-1->2 selfNs" per line) for flamegraph.pl
+//     and speedscope
+class SearchTrace
+{
+public:
+    enum class Branch : quint8 {
+        ROOT,
+        INCLUDE,
+        EXCLUDE
+    };
+
+    enum class Outcome : quint8 {
+        OPEN,     // Interrupted by time limit
+        BRANCHED,
+        PRUNED,   // Bound is worse than the record
+        DEAD_END, // No paths left, tour is not complete
+        SOLUTION, // Complete tour, not better than the record
+        RECORD
+    };
+
+    struct Node {
+        quint32 parent = noNode;
+        quint32 includeChild = noNode;
+        quint32 excludeChild = noNode;
+        quint32 subtreeEnd = 0; // Last node of the subtree
+        float bound = 0.f;
+        qint32 from = -1; // Branching path, -1 for the root
+        qint32 to = -1;
+        quint32 depth = 0;
+        Branch branch = Branch::ROOT;
+        Outcome outcome = Outcome::OPEN;
+        quint64 startInNs = 0;
+        quint64 durationInNs = 0; // Whole subtree
+    };
+
+    static constexpr quint32 noNode = 0xffffffffu;
+
+    // Nodes beyond maxNodes are not recorded (see isTruncated), 0 means no limit
+    explicit SearchTrace(const size_t maxNodes = 4u * 1024u * 1024u);
+
+    void setMaxNodes(const size_t maxNodes) { m_maxNodes = maxNodes; }
+    void clear();
+
+    // Recording, returns noNode when the trace is full
+    quint32 beginNode(const quint32 parent, const Branch branch, const QPoint &path, const int depth, const float bound);
+    void endNode(const quint32 id);
+    void setBound(const quint32 id, const float bound) { m_nodes[int(id)].bound = bound; }
+    void setOutcome(const quint32 id, const Outcome outcome) { m_nodes[int(id)].outcome = outcome; }
+
+    int size() const { return m_nodes.size(); }
+    bool isEmpty() const { return m_nodes.isEmpty(); }
+    bool isTruncated() const { return m_isTruncated; }
+    const Node &node(const quint32 id) const { return m_nodes[int(id)]; }
+    // Children in branching order (include first), at most 2
+    int childCount(const quint32 id) const;
+    quint32 child(const quint32 id, const int index) const;
+    quint64 selfTimeInNs(const quint32 id) const;
+
+    bool writeChromeTrace(const QString &fileName, QString &error) const;
+    bool writeCollapsedStacks(const QString &fileName, QString &error) const;
+
+    // "root", "+from->to" or "-from->to"
+    static QString nodeName(const Node &node);
+    static QString outcomeName(const Outcome outcome);
+
+private:
+    quint64 elapsedInNs() const;
+
+private:
+    size_t m_maxNodes = 0;
+    bool m_isTruncated = false;
+    std::chrono::steady_clock::time_point m_startTime;
+    QVector<Node> m_nodes;
+};
+
+#endif // SEARCHTRACE_H
@@ -0,0 +1,106 @@
+#include "searchtreemodel.h"
+
+#include "tspsolver.h"
+
+SearchTreeModel::SearchTreeModel(QObject *parent)
+    : QAbstractItemModel(parent)
+{
+}
+
+void SearchTreeModel::setTrace(const SearchTrace *trace)
+{
+    beginResetModel();
+    m_trace = trace;
+    endResetModel();
+}
+
+QModelIndex SearchTreeModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (!hasIndex(row, column, parent))
+        return QModelIndex();
+    if (!parent.isValid())
+        return createIndex(row, column, quintptr(0)); // Root is always the first node
+    return createIndex(row, column, quintptr(m_trace->child(quint32(parent.internalId()), row)));
+}
+
+QModelIndex SearchTreeModel::parent(const QModelIndex &index) const
+{
+    if (!index.isValid() || m_trace == nullptr)
+        return QModelIndex();
+    const quint32 parentId = m_trace->node(quint32(index.internalId())).parent;
+    if (parentId == SearchTrace::noNode)
+        return QModelIndex();
+    const quint32 grandParentId = m_trace->node(parentId).parent;
+    int row = 0;
+    if (grandParentId != SearchTrace::noNode && m_trace->child(grandParentId, 0) != parentId)
+        row = 1;
+    return createIndex(row, 0, quintptr(parentId));
+}
+
+int SearchTreeModel::rowCount(const QModelIndex &parent) const
+{
+    if (m_trace == nullptr || m_trace->isEmpty() || parent.column() > 0)
+        return 0;
+    if (!parent.isValid())
+        return 1;
+    return m_trace->childCount(quint32(parent.internalId()));
+}
+
+int SearchTreeModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return COLUMN_COUNT;
+}
+
+bool SearchTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    return rowCount(parent) > 0;
+}
+
+QVariant SearchTreeModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || m_trace == nullptr)
+        return QVariant();
+    const quint32 id = quint32(index.internalId());
+    const SearchTrace::Node &node = m_trace->node(id);
+    if (role == Qt::DisplayRole) {
+        switch (index.column()) {
+        case NODE:
+            return SearchTrace::nodeName(node);
+        case BOUND:
+            return node.bound;
+        case OUTCOME:
+            return SearchTrace::outcomeName(node.outcome);
+        case NODES:
+            return node.subtreeEnd - id + 1;
+        case TIME:
+            return TspSolver::getConvertedTime(node.durationInNs);
+        case SELF_TIME:
+            return TspSolver::getConvertedTime(m_trace->selfTimeInNs(id));
+        }
+    }
+    else if (role == Qt::TextAlignmentRole && index.column() != NODE && index.column() != OUTCOME)
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    return QVariant();
+}
+
+QVariant SearchTreeModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QVariant();
+    switch (section) {
+    case NODE:
+        return "Node";
+    case BOUND:
+        return "Bound";
+    case OUTCOME:
+        return "Outcome";
+    case NODES:
+        return "Subtree nodes";
+    case TIME:
+        return "Subtree time";
+    case SELF_TIME:
+        return "Self time";
+    }
+    return QVariant();
+}
@@ -0,0 +1,43 @@
+#ifndef SEARCHTREEMODEL_H
+#define SEARCHTREEMODEL_H
+
+#include <QAbstractItemModel>
+
+#include "searchtrace.h"
+
+// Read-only view of SearchTrace for QTreeView. Indexes are created only for
+// rows the view asks for (internal id is the node id), so expanding a branch
+// of a trace with millions of nodes costs nothing but the visible rows.
+class SearchTreeModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    enum Column : int {
+        NODE,
+        BOUND,
+        OUTCOME,
+        NODES,
+        TIME,
+        SELF_TIME,
+        COLUMN_COUNT
+    };
+
+    explicit SearchTreeModel(QObject *parent = nullptr);
+
+    // nullptr detaches the model, e.g. while the trace is being recorded
+    void setTrace(const SearchTrace *trace);
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &index) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    const SearchTrace *m_trace = nullptr;
+};
+
+#endif // SEARCHTREEMODEL_H
@@ -0,0 +1,43 @@
+#include "solverclient.h"
+
+#include "solverprotocol.h"
+
+bool SolverClient::connectToServer(const QString &name, const int timeoutInMs)
+{
+    m_socket.connectToServer(name);
+    if (!m_socket.waitForConnected(timeoutInMs)) {
+        m_error = m_socket.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool SolverClient::send(const QJsonObject &request)
+{
+    m_socket.write(SolverProtocol::encodeFrame(request));
+    if (!m_socket.waitForBytesWritten(-1) && m_socket.bytesToWrite() > 0) {
+        m_error = m_socket.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool SolverClient::receive(QJsonObject &response, const int timeoutInMs)
+{
+    for (;;) {
+        switch (SolverProtocol::takeFrame(m_buffer, response)) {
+        case SolverProtocol::FrameStatus::READY:
+            return true;
+        case SolverProtocol::FrameStatus::INVALID:
+            m_error = "Malformed frame from server";
+            return false;
+        case SolverProtocol::FrameStatus::INCOMPLETE:
+            break;
+        }
+        if (!m_socket.waitForReadyRead(timeoutInMs)) {
+            m_error = m_socket.errorString();
+            return false;
+        }
+        m_buffer.append(m_socket.readAll());
+    }
+}
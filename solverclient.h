@@ -0,0 +1,25 @@
+#ifndef SOLVERCLIENT_H
+#define SOLVERCLIENT_H
+
+#include <QLocalSocket>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+// Blocking client for SolverServer, used by the "--client" test mode
+class SolverClient
+{
+public:
+    bool connectToServer(const QString &name, const int timeoutInMs);
+    bool send(const QJsonObject &request);
+    // Waits for the next response frame, timeoutInMs < 0 waits forever
+    bool receive(QJsonObject &response, const int timeoutInMs);
+    QString errorString() const { return m_error; }
+
+private:
+    QLocalSocket m_socket;
+    QByteArray m_buffer;
+    QString m_error;
+};
+
+#endif // SOLVERCLIENT_H
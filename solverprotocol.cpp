@@ -0,0 +1,297 @@
+#include "solverprotocol.h"
+
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QtEndian>
+
+QByteArray SolverProtocol::encodeFrame(const QJsonObject &object)
+{
+    const QByteArray payload = QJsonDocument(object).toJson(QJsonDocument::Compact);
+    QByteArray frame(4, Qt::Uninitialized);
+    qToBigEndian<quint32>(quint32(payload.size()), reinterpret_cast<uchar *>(frame.data()));
+    frame.append(payload);
+    return frame;
+}
+
+SolverProtocol::FrameStatus SolverProtocol::takeFrame(QByteArray &buffer, QJsonObject &object)
+{
+    if (buffer.size() < 4)
+        return FrameStatus::INCOMPLETE;
+    const quint32 payloadSize = qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(buffer.constData()));
+    if (payloadSize > maxFrameSize) {
+        buffer.clear();
+        return FrameStatus::INVALID;
+    }
+    if (quint32(buffer.size()) - 4u < payloadSize)
+        return FrameStatus::INCOMPLETE;
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(buffer.mid(4, int(payloadSize)), &parseError);
+    buffer.remove(0, int(payloadSize) + 4);
+    if (parseError.error != QJsonParseError::NoError || !document.isObject())
+        return FrameStatus::INVALID;
+
+    object = document.object();
+    return FrameStatus::READY;
+}
+
+QJsonObject SolverProtocol::makeRequest(
+        const QJsonValue &id,
+        const QVector<float> &mat,
+        const int size,
+        const AnswerType answerType,
+        const int timeLimitInMs,
+        const bool presolve,
+        const BranchingStrategy::Type branching)
+{
+    QJsonObject request;
+    request.insert("id", id);
+    request.insert("size", size);
+    request.insert("matrix", matrixToJson(mat, size));
+    request.insert("answerType", answerType == AnswerType::ALL ? "all" : "first");
+    if (timeLimitInMs > 0)
+        request.insert("timeLimitMs", timeLimitInMs);
+    request.insert("presolve", presolve);
+    request.insert("branching", BranchingStrategy::typeName(branching));
+    return request;
+}
+
+QJsonObject SolverProtocol::makeRequest(
+        const QJsonValue &id,
+        const SparseGraph &graph,
+        const AnswerType answerType,
+        const int timeLimitInMs,
+        const bool presolve,
+        const BranchingStrategy::Type branching)
+{
+    QJsonObject request;
+    request.insert("id", id);
+    request.insert("size", graph.size());
+    request.insert("edges", graphToJson(graph));
+    request.insert("answerType", answerType == AnswerType::ALL ? "all" : "first");
+    if (timeLimitInMs > 0)
+        request.insert("timeLimitMs", timeLimitInMs);
+    request.insert("presolve", presolve);
+    request.insert("branching", BranchingStrategy::typeName(branching));
+    return request;
+}
+
+bool SolverProtocol::parseRequest(
+        const QJsonObject &request,
+        QVector<float> &mat,
+        SparseGraph &graph,
+        int &size,
+        AnswerType &answerType,
+        int &timeLimitInMs,
+        bool &presolve,
+        BranchingStrategy::Type &branching,
+        QString &error)
+{
+    size = request.value("size").toInt(0);
+    if (size < 2) {
+        error = "size must be at least 2";
+        return false;
+    }
+    if (size > maxSize) { // Checked before anything of that size is allocated
+        error = QString("size must be at most %1").arg(maxSize);
+        return false;
+    }
+    mat.clear();
+    graph = SparseGraph();
+    if (request.contains("edges")) {
+        const QJsonArray edges = request.value("edges").toArray();
+        if (edges.size() < size) {
+            error = "edges must contain a path out of every city, at least size triples";
+            return false;
+        }
+        if (!graphFromJson(edges, size, graph)) {
+            error = "edges must be [from, to, weight] triples with cities in [0, size)";
+            return false;
+        }
+    }
+    else if (!matrixFromJson(request.value("matrix").toArray(), size, mat)) {
+        error = QString("matrix must contain size * size = %1 values").arg(qint64(size) * size);
+        return false;
+    }
+
+    const QString answerTypeName = request.value("answerType").toString("first");
+    if (answerTypeName == "first")
+        answerType = AnswerType::FIRST;
+    else if (answerTypeName == "all")
+        answerType = AnswerType::ALL;
+    else {
+        error = "answerType must be \"first\" or \"all\"";
+        return false;
+    }
+    timeLimitInMs = qMax(0, request.value("timeLimitMs").toInt(0));
+    presolve = request.value("presolve").toBool(false);
+    const QString branchingName = request.value("branching").toString(BranchingStrategy::typeName(BranchingStrategy::Type::MAX_PENALTY));
+    if (!BranchingStrategy::typeFromName(branchingName, branching)) {
+        error = "branching must be one of: " + BranchingStrategy::typeNames().join(", ");
+        return false;
+    }
+    return true;
+}
+
+QJsonObject SolverProtocol::makeResponse(const QJsonValue &id, const TspSolver::Result &result, const bool isPresolveRequested)
+{
+    QJsonArray tours;
+    for (const Tour &tour : result.routes) {
+        QJsonArray cities;
+        for (const int city : tour.cities())
+            cities.append(city);
+        tours.append(cities);
+    }
+
+    QJsonObject response;
+    response.insert("id", id);
+    response.insert("status", result.timedOut ? "timeout" : "ok");
+    if (result.hasRoute())
+        response.insert("length", double(result.length));
+    response.insert("tours", tours);
+    response.insert("nodes", double(result.nodes));
+    response.insert("timeNs", double(result.timeInNs));
+    response.insert("branching", BranchingStrategy::typeName(result.branching));
+    if (result.lookaheads > 0)
+        response.insert("lookaheads", double(result.lookaheads));
+    if (result.isSparse)
+        response.insert("sparse", true);
+    if (result.presolve.isDone) {
+        QJsonObject presolve;
+        presolve.insert("lowerBound", double(result.presolve.lowerBound));
+        if (result.presolve.upperBound != std::numeric_limits<float>::max())
+            presolve.insert("upperBound", double(result.presolve.upperBound));
+        presolve.insert("edges", result.presolve.nEdges);
+        presolve.insert("removed", result.presolve.nRemoved);
+        presolve.insert("fixed", result.presolve.nFixed);
+        presolve.insert("timeNs", double(result.presolve.timeInNs));
+        response.insert("presolve", presolve);
+    }
+    else if (isPresolveRequested)
+        response.insert("presolve", QJsonObject({{"isDone", false}}));
+    if (result.estimate.isDone) {
+        QJsonObject estimate;
+        estimate.insert("totalNodes", result.estimate.totalNodes);
+        estimate.insert("probes", result.estimate.nProbes);
+        estimate.insert("lowerBound", double(result.estimate.lowerBound));
+        if (result.estimate.gap >= 0.f)
+            estimate.insert("gap", double(result.estimate.gap));
+        if (result.estimate.remainingInNs >= 0)
+            estimate.insert("remainingNs", double(result.estimate.remainingInNs));
+        if (result.estimate.nodeRemainingInNs >= 0)
+            estimate.insert("nodeRemainingNs", double(result.estimate.nodeRemainingInNs));
+        if (result.estimate.gapRemainingInNs >= 0)
+            estimate.insert("gapRemainingNs", double(result.estimate.gapRemainingInNs));
+        response.insert("estimate", estimate);
+    }
+    return response;
+}
+
+QJsonObject SolverProtocol::makeError(const QJsonValue &id, const QString &status, const QString &error)
+{
+    QJsonObject response;
+    response.insert("id", id);
+    response.insert("status", status);
+    response.insert("error", error);
+    return response;
+}
+
+QJsonArray SolverProtocol::matrixToJson(const QVector<float> &mat, const int size)
+{
+    QJsonArray values;
+    for (int row = 0; row < size; ++row)
+        for (int col = 0; col < size; ++col)
+            values.append(double(qMax(-1.f, TspSolver::get(mat, size, row, col))));
+    return values;
+}
+
+bool SolverProtocol::matrixFromJson(const QJsonArray &values, const int size, QVector<float> &mat)
+{
+    if (qint64(values.size()) != qint64(size) * size)
+        return false;
+
+    mat.resize(size * size);
+    for (int row = 0; row < size; ++row)
+        for (int col = 0; col < size; ++col) {
+            const QJsonValue value = values[row * size + col];
+            if (row == col || !value.isDouble() || value.toDouble() < 0.0) {
+                TspSolver::get(mat, size, row, col) = -1.f;
+                continue;
+            }
+            TspSolver::get(mat, size, row, col) = float(value.toDouble());
+        }
+    return true;
+}
+
+QJsonArray SolverProtocol::graphToJson(const SparseGraph &graph)
+{
+    QJsonArray edges;
+    for (int edge = 0; edge < graph.edgeCount(); ++edge)
+        edges.append(QJsonArray({graph.from(edge), graph.to(edge), double(graph.weights()[edge])}));
+    return edges;
+}
+
+bool SolverProtocol::graphFromJson(const QJsonArray &edges, const int size, SparseGraph &graph)
+{
+    QVector<SparseGraph::Edge> graphEdges;
+    graphEdges.reserve(edges.size());
+    for (const QJsonValue &value : edges) {
+        const QJsonArray edge = value.toArray();
+        if (edge.size() != 3 || !edge[0].isDouble() || !edge[1].isDouble() || !edge[2].isDouble())
+            return false;
+        const int from = edge[0].toInt(-1);
+        const int to = edge[1].toInt(-1);
+        if (from < 0 || from >= size || to < 0 || to >= size)
+            return false;
+        graphEdges.push_back({from, to, float(edge[2].toDouble())});
+    }
+    graph = SparseGraph(size, graphEdges);
+    return true;
+}
+
+QJsonArray SolverProtocol::routeToJson(const QVector<QPoint> &route)
+{
+    QJsonArray paths;
+    for (const QPoint &path : route)
+        paths.append(QJsonArray({path.x(), path.y()}));
+    return paths;
+}
+
+QVector<QPoint> SolverProtocol::routeFromJson(const QJsonArray &paths)
+{
+    QVector<QPoint> route;
+    route.reserve(paths.size());
+    for (const QJsonValue &value : paths) {
+        const QJsonArray path = value.toArray();
+        route.push_back(QPoint(path.at(0).toInt(), path.at(1).toInt()));
+    }
+    return route;
+}
+
+QJsonValue SolverProtocol::tourToJson(const Tour &tour)
+{
+    return QString::fromLatin1(tour.toBinary().toBase64());
+}
+
+Tour SolverProtocol::tourFromJson(const QJsonValue &value)
+{
+    return Tour::fromBinary(QByteArray::fromBase64(value.toString().toLatin1()));
+}
+
+QJsonObject SolverProtocol::subproblemToJson(const TspSolver::Subproblem &subproblem)
+{
+    QJsonObject object;
+    object.insert("included", routeToJson(subproblem.included));
+    object.insert("excluded", routeToJson(subproblem.excluded));
+    object.insert("bound", double(subproblem.bound));
+    return object;
+}
+
+TspSolver::Subproblem SolverProtocol::subproblemFromJson(const QJsonObject &object)
+{
+    TspSolver::Subproblem subproblem;
+    subproblem.included = routeFromJson(object.value("included").toArray());
+    subproblem.excluded = routeFromJson(object.value("excluded").toArray());
+    subproblem.bound = float(object.value("bound").toDouble());
+    return subproblem;
+}
@@ -0,0 +1,92 @@
+#ifndef SOLVERPROTOCOL_H
+#define SOLVERPROTOCOL_H
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QVector>
+#include <QString>
+
+#include "tspsolver.h"
+
+// Wire format of the solver server: every frame is a 4 byte big-endian
+// payload length followed by one compact JSON object.
+//
+// Request:  {"id": any, "size": n, "matrix": [n * n row-major values],
+//            "answerType": "first" | "all", "timeLimitMs": int, "presolve": bool (false if missing),
+//            "branching": "max-penalty" | "strong" | "most-constrained"}
+//           Negative or null matrix values mean "no edge", diagonal is ignored.
+//           Sparse graphs send "edges": [[from, to, weight], ...] instead of "matrix".
+//           n is at most maxSize, a graph needs at least n edges.
+// Response: {"id": any, "status": "ok" | "timeout" | "error" | "rejected",
+//            "length": float, "tours": [[0, c1, c2, ...], ...],
+//            "nodes": int, "timeNs": int, "queueNs": int, "error": string,
+//            "branching": string, "lookaheads": int, "sparse": true,
+//            "presolve": {"lowerBound", "upperBound", "edges", "removed", "fixed", "timeNs"}}
+//           The edge list engine ("sparse": true) has no presolve, a request for it
+//           gets "presolve": {"isDone": false} instead.
+class SolverProtocol
+{
+public:
+    enum class FrameStatus : int {
+        INCOMPLETE,
+        READY,
+        INVALID
+    };
+
+    static constexpr quint32 maxFrameSize = 256u * 1024u * 1024u;
+    // Such a matrix of at least 2 bytes ("0,") per value still fits into a frame
+    static constexpr int maxSize = TspSolver::maxSize;
+
+    static QByteArray encodeFrame(const QJsonObject &object);
+    // Takes one frame from the front of buffer. INVALID means the stream can not be trusted anymore
+    static FrameStatus takeFrame(QByteArray &buffer, QJsonObject &object);
+
+    static QJsonObject makeRequest(
+            const QJsonValue &id,
+            const QVector<float> &mat,
+            const int size,
+            const AnswerType answerType,
+            const int timeLimitInMs,
+            const bool presolve = false,
+            const BranchingStrategy::Type branching = BranchingStrategy::Type::MAX_PENALTY);
+    static QJsonObject makeRequest(
+            const QJsonValue &id,
+            const SparseGraph &graph,
+            const AnswerType answerType,
+            const int timeLimitInMs,
+            const bool presolve = false,
+            const BranchingStrategy::Type branching = BranchingStrategy::Type::MAX_PENALTY);
+    // Fills graph for "edges" requests (mat is left empty), mat otherwise (graph is left empty)
+    static bool parseRequest(
+            const QJsonObject &request,
+            QVector<float> &mat,
+            SparseGraph &graph,
+            int &size,
+            AnswerType &answerType,
+            int &timeLimitInMs,
+            bool &presolve,
+            BranchingStrategy::Type &branching,
+            QString &error);
+    // isPresolveRequested adds "presolve": {"isDone": false} when the engine skipped presolve
+    static QJsonObject makeResponse(const QJsonValue &id, const TspSolver::Result &result, const bool isPresolveRequested = false);
+    static QJsonObject makeError(const QJsonValue &id, const QString &status, const QString &error);
+
+    // Row-major values, "no edge" is written as -1
+    static QJsonArray matrixToJson(const QVector<float> &mat, const int size);
+    static bool matrixFromJson(const QJsonArray &values, const int size, QVector<float> &mat);
+    // Edges as [[from, to, weight], ...]
+    static QJsonArray graphToJson(const SparseGraph &graph);
+    static bool graphFromJson(const QJsonArray &edges, const int size, SparseGraph &graph);
+    // Paths as [[from, to], ...]
+    static QJsonArray routeToJson(const QVector<QPoint> &route);
+    static QVector<QPoint> routeFromJson(const QJsonArray &paths);
+    // Base64 of Tour::toBinary(): size + 1 integers instead of size pairs, empty tour if broken
+    static QJsonValue tourToJson(const Tour &tour);
+    static Tour tourFromJson(const QJsonValue &value);
+    static QJsonObject subproblemToJson(const TspSolver::Subproblem &subproblem);
+    static TspSolver::Subproblem subproblemFromJson(const QJsonObject &object);
+};
+
+#endif // SOLVERPROTOCOL_H
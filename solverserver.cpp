@@ -0,0 +1,173 @@
+#include "solverserver.h"
+
+#include "solverprotocol.h"
+
+#include <QJsonArray>
+
+SolverServer::SolverServer(QObject *parent)
+    : QObject(parent)
+{
+    // Worker threads must live as long as the server to keep their buffers warm
+    m_pool.setExpiryTimeout(-1);
+    m_pool.setMaxThreadCount(m_workerCount);
+    connect(&m_server, &QLocalServer::newConnection, this, &SolverServer::onNewConnection);
+}
+
+SolverServer::~SolverServer()
+{
+    m_server.close();
+    m_pool.clear();
+    for (const std::shared_ptr<std::atomic<bool>> &cancel : qAsConst(m_runningCancels))
+        cancel->store(true, std::memory_order_relaxed);
+    m_pool.waitForDone();
+}
+
+void SolverServer::setWorkerCount(const int count)
+{
+    m_workerCount = qMax(1, count);
+    m_pool.setMaxThreadCount(m_workerCount);
+}
+
+bool SolverServer::listen(const QString &name)
+{
+    QLocalServer::removeServer(name); // Stale socket file after a crash
+    m_server.setSocketOptions(QLocalServer::UserAccessOption);
+    return m_server.listen(name);
+}
+
+void SolverServer::onNewConnection()
+{
+    while (QLocalSocket *socket = m_server.nextPendingConnection()) {
+        m_readBuffers.insert(socket, QByteArray());
+        connect(socket, &QLocalSocket::readyRead, this, &SolverServer::onReadyRead);
+        connect(socket, &QLocalSocket::disconnected, this, &SolverServer::onDisconnected);
+    }
+}
+
+void SolverServer::onReadyRead()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+    if (socket == nullptr)
+        return;
+    QByteArray &buffer = m_readBuffers[socket];
+    buffer.append(socket->readAll());
+
+    QJsonObject request;
+    SolverProtocol::FrameStatus status;
+    while ((status = SolverProtocol::takeFrame(buffer, request)) == SolverProtocol::FrameStatus::READY)
+        handleRequest(socket, request);
+    if (status == SolverProtocol::FrameStatus::INVALID) {
+        sendFrame(socket, SolverProtocol::makeError(QJsonValue(), "error", "Malformed frame"));
+        socket->disconnectFromServer();
+    }
+    dispatch();
+}
+
+void SolverServer::onDisconnected()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+    if (socket == nullptr)
+        return;
+    m_readBuffers.remove(socket);
+    socket->deleteLater();
+
+    // Nobody waits for the answers: queued tasks of the socket are dropped, running ones stopped
+    for (int i = m_queue.size() - 1; i >= 0; --i) {
+        if (m_taskSockets.value(m_queue[i].taskId).data() != socket)
+            continue;
+        m_taskSockets.remove(m_queue[i].taskId);
+        m_queuedBytes -= m_queue[i].bytes;
+        m_queue.removeAt(i);
+    }
+    for (auto it = m_runningCancels.begin(); it != m_runningCancels.end(); ++it)
+        if (m_taskSockets.value(it.key()).data() == socket)
+            it.value()->store(true, std::memory_order_relaxed);
+}
+
+void SolverServer::handleRequest(QLocalSocket *socket, const QJsonObject &request)
+{
+    const QJsonValue id = request.value("id");
+    // Both limits are checked before the matrix is built
+    if (m_queue.size() >= m_maxQueueSize) {
+        sendFrame(socket, SolverProtocol::makeError(id, "rejected", "Request queue is full"));
+        return;
+    }
+    Task task;
+    task.bytes = requestBytes(request);
+    if (!m_queue.isEmpty() && m_queuedBytes + task.bytes > m_maxQueuedBytes) {
+        sendFrame(socket, SolverProtocol::makeError(id, "rejected", "Request queue memory is full"));
+        return;
+    }
+    QString error;
+    if (!SolverProtocol::parseRequest(request, task.mat, task.graph, task.size, task.answerType, task.timeLimitInMs, task.presolve, task.branching, error)) {
+        sendFrame(socket, SolverProtocol::makeError(id, "error", error));
+        return;
+    }
+    if (!request.contains("timeLimitMs"))
+        task.timeLimitInMs = m_defaultTimeLimitInMs;
+    task.taskId = m_nextTaskId++;
+    task.id = id;
+    task.queuedAt = std::chrono::steady_clock::now();
+    task.cancel = std::make_shared<std::atomic<bool>>(false);
+    m_taskSockets.insert(task.taskId, QPointer<QLocalSocket>(socket));
+    m_queuedBytes += task.bytes;
+    m_queue.enqueue(task);
+}
+
+qint64 SolverServer::requestBytes(const QJsonObject &request)
+{
+    const qint64 size = qBound(0, request.value("size").toInt(0), TspSolver::maxSize);
+    if (request.contains("edges")) // CSR arrays: from, to, weight and column order per edge, two offsets per city
+        return qint64(request.value("edges").toArray().size()) * qint64(3 * sizeof(int) + sizeof(float))
+                + 2 * (size + 1) * qint64(sizeof(int));
+    return size * size * qint64(sizeof(float));
+}
+
+void SolverServer::dispatch()
+{
+    while (m_busyWorkers < m_workerCount && !m_queue.isEmpty()) {
+        const Task task = m_queue.dequeue();
+        m_queuedBytes -= task.bytes;
+        if (m_taskSockets.value(task.taskId).isNull()) { // Client is gone, nobody waits for the answer
+            m_taskSockets.remove(task.taskId);
+            continue;
+        }
+
+        ++m_busyWorkers;
+        m_runningCancels.insert(task.taskId, task.cancel);
+        const size_t queueInNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - task.queuedAt).count();
+        m_pool.start([this, task, queueInNs]() {
+            thread_local TspSolver solver;
+            solver.setTimeLimit(size_t(task.timeLimitInMs));
+            solver.setPresolve(task.presolve);
+            solver.setBranching(task.branching);
+            solver.setCancelFlag(task.cancel.get());
+            const TspSolver::Result result = task.graph.isEmpty()
+                    ? solver.solveBranchAndBound(task.mat, task.size, task.answerType)
+                    : solver.solveBranchAndBound(task.graph, task.answerType);
+            solver.setCancelFlag(nullptr);
+            QJsonObject response = SolverProtocol::makeResponse(task.id, result, task.presolve);
+            response.insert("queueNs", double(queueInNs));
+            QMetaObject::invokeMethod(this, [this, taskId = task.taskId, response]() {
+                finishTask(taskId, response);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+void SolverServer::finishTask(const quint64 taskId, const QJsonObject &response)
+{
+    --m_busyWorkers;
+    m_runningCancels.remove(taskId);
+    const QPointer<QLocalSocket> socket = m_taskSockets.take(taskId);
+    if (!socket.isNull())
+        sendFrame(socket, response);
+    dispatch();
+}
+
+void SolverServer::sendFrame(QLocalSocket *socket, const QJsonObject &object)
+{
+    if (socket->state() != QLocalSocket::ConnectedState)
+        return;
+    socket->write(SolverProtocol::encodeFrame(object));
+}
@@ -0,0 +1,86 @@
+#ifndef SOLVERSERVER_H
+#define SOLVERSERVER_H
+
+#include <QObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPointer>
+#include <QQueue>
+#include <QHash>
+#include <QThreadPool>
+#include <QJsonObject>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include "tspsolver.h"
+
+// Long-running headless solver listening on a local socket
+// (Unix domain socket / Windows named pipe, see SolverProtocol for framing).
+// Requests are queued and solved on a fixed pool of worker threads,
+// each of them keeps its own warm TspSolver between requests.
+class SolverServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SolverServer(QObject *parent = nullptr);
+    ~SolverServer();
+
+    void setWorkerCount(const int count);
+    void setMaxQueueSize(const int size) { m_maxQueueSize = size; }
+    // Limit of the matrices and graphs of all queued requests, one request is always accepted
+    void setMaxQueuedBytes(const qint64 bytes) { m_maxQueuedBytes = bytes; }
+    // Used when request has no "timeLimitMs", 0 means no time limit
+    void setDefaultTimeLimit(const int timeLimitInMs) { m_defaultTimeLimitInMs = timeLimitInMs; }
+
+    bool listen(const QString &name);
+    QString errorString() const { return m_server.errorString(); }
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onDisconnected();
+
+private:
+    struct Task {
+        quint64 taskId = 0;
+        QJsonValue id;
+        QVector<float> mat;
+        SparseGraph graph; // Instead of mat for "edges" requests
+        int size = 0;
+        AnswerType answerType = AnswerType::FIRST;
+        int timeLimitInMs = 0;
+        bool presolve = false;
+        BranchingStrategy::Type branching = BranchingStrategy::Type::MAX_PENALTY;
+        std::chrono::steady_clock::time_point queuedAt;
+        qint64 bytes = 0; // See requestBytes
+        std::shared_ptr<std::atomic<bool>> cancel; // Set when the client is gone
+    };
+
+    void handleRequest(QLocalSocket *socket, const QJsonObject &request);
+    // Memory the matrix or graph of a request will take, known before it is parsed
+    static qint64 requestBytes(const QJsonObject &request);
+    void dispatch();
+    void finishTask(const quint64 taskId, const QJsonObject &response);
+    static void sendFrame(QLocalSocket *socket, const QJsonObject &object);
+
+private:
+    QLocalServer m_server;
+    QThreadPool m_pool;
+    int m_workerCount = 1;
+    int m_busyWorkers = 0;
+    int m_maxQueueSize = 1024;
+    qint64 m_maxQueuedBytes = 1024ll * 1024ll * 1024ll;
+    qint64 m_queuedBytes = 0;
+    int m_defaultTimeLimitInMs = 0;
+
+    quint64 m_nextTaskId = 1;
+    QQueue<Task> m_queue;
+    QHash<quint64, QPointer<QLocalSocket>> m_taskSockets;
+    QHash<quint64, std::shared_ptr<std::atomic<bool>>> m_runningCancels;
+    QHash<QLocalSocket *, QByteArray> m_readBuffers;
+};
+
+#endif // SOLVERSERVER_H
@@ -0,0 +1,84 @@
+#include "sparsegraph.h"
+
+#include "tspsolver.h"
+
+#include <algorithm>
+
+SparseGraph::SparseGraph(const int size, QVector<Edge> edges)
+    : m_size(size > TspSolver::maxSize ? 0 : qMax(0, size))
+{
+    edges.erase(std::remove_if(edges.begin(), edges.end(), [this](const Edge &edge) {
+        return edge.from == edge.to || edge.weight < 0.f
+                || edge.from < 0 || edge.from >= m_size || edge.to < 0 || edge.to >= m_size;
+    }), edges.end());
+    std::sort(edges.begin(), edges.end(), [](const Edge &a, const Edge &b) {
+        if (a.from != b.from)
+            return a.from < b.from;
+        if (a.to != b.to)
+            return a.to < b.to;
+        return a.weight < b.weight;
+    });
+    edges.erase(std::unique(edges.begin(), edges.end(), [](const Edge &a, const Edge &b) {
+        return a.from == b.from && a.to == b.to;
+    }), edges.end());
+
+    const int nEdges = edges.size();
+    m_rowBegin.fill(0, m_size + 1);
+    m_colBegin.fill(0, m_size + 1);
+    m_from.resize(nEdges);
+    m_to.resize(nEdges);
+    m_weights.resize(nEdges);
+    for (int edge = 0; edge < nEdges; ++edge) {
+        m_from[edge] = edges[edge].from;
+        m_to[edge] = edges[edge].to;
+        m_weights[edge] = edges[edge].weight;
+        ++m_rowBegin[edges[edge].from + 1];
+        ++m_colBegin[edges[edge].to + 1];
+    }
+    for (int i = 0; i < m_size; ++i) {
+        m_rowBegin[i + 1] += m_rowBegin[i];
+        m_colBegin[i + 1] += m_colBegin[i];
+    }
+
+    // Counting sort by column keeps the row order inside every column
+    m_colEdges.resize(nEdges);
+    QVector<int> colFill = m_colBegin;
+    for (int edge = 0; edge < nEdges; ++edge)
+        m_colEdges[colFill[m_to[edge]]++] = edge;
+}
+
+SparseGraph SparseGraph::fromMatrix(const QVector<float> &mat, const int size)
+{
+    QVector<Edge> edges;
+    for (int col = 0; col < size; ++col)
+        for (int row = 0; row < size; ++row) {
+            const float value = TspSolver::get(mat, size, row, col);
+            if (row != col && value >= 0.f)
+                edges.push_back({row, col, value});
+        }
+    return SparseGraph(size, edges);
+}
+
+void SparseGraph::fillMatrix(QVector<float> &mat) const
+{
+    mat.fill(-1.f, m_size * m_size);
+    for (int edge = 0; edge < edgeCount(); ++edge)
+        TspSolver::get(mat, m_size, m_from[edge], m_to[edge]) = m_weights[edge];
+}
+
+double SparseGraph::density() const
+{
+    if (m_size < 2)
+        return 1.;
+    return double(edgeCount()) / (double(m_size) * double(m_size - 1));
+}
+
+int SparseGraph::findEdge(const int from, const int to) const
+{
+    const auto begin = m_to.constBegin() + m_rowBegin[from];
+    const auto end = m_to.constBegin() + m_rowBegin[from + 1];
+    const auto it = std::lower_bound(begin, end, to);
+    if (it == end || *it != to)
+        return -1;
+    return int(it - m_to.constBegin());
+}
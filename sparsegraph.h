@@ -0,0 +1,59 @@
+#ifndef SPARSEGRAPH_H
+#define SPARSEGRAPH_H
+
+#include <QVector>
+
+// Directed graph in compressed sparse row (CSR) form: memory is O(n + m) for
+// m edges instead of the n * n of the solver matrix. Edges are numbered in
+// (from, to) order, a column index over the same edges is sorted by (to, from),
+// so row and column scans visit edges in the order of the dense matrix loops.
+class SparseGraph
+{
+public:
+    struct Edge {
+        int from = 0;
+        int to = 0;
+        float weight = 0.f;
+    };
+
+    // Share of the n * (n - 1) possible paths below which branch and bound runs on edges
+    static constexpr double sparseDensity = 0.25;
+
+    SparseGraph() = default;
+    // Self loops, negative weights and edges out of range are dropped, of parallel edges the shortest is kept.
+    // Empty graph if size is above TspSolver::maxSize.
+    SparseGraph(const int size, QVector<Edge> edges);
+    // Every non-negative value of the solver matrix is an edge
+    static SparseGraph fromMatrix(const QVector<float> &mat, const int size);
+    // Solver matrix, -1 where there is no edge
+    void fillMatrix(QVector<float> &mat) const;
+
+    bool isEmpty() const { return m_size == 0; }
+    int size() const { return m_size; }
+    int edgeCount() const { return m_to.size(); }
+    double density() const;
+    bool isSparse() const { return density() < sparseDensity; }
+
+    // Edges of row are [rowBegin(row), rowBegin(row + 1))
+    int rowBegin(const int row) const { return m_rowBegin[row]; }
+    // Edges of column are colEdge(i) for i in [colBegin(col), colBegin(col + 1))
+    int colBegin(const int col) const { return m_colBegin[col]; }
+    int colEdge(const int i) const { return m_colEdges[i]; }
+    int from(const int edge) const { return m_from[edge]; }
+    int to(const int edge) const { return m_to[edge]; }
+    // Weight of every edge, the per-node weights of branch and bound start from it
+    const QVector<float> &weights() const { return m_weights; }
+    // -1 if there is no such edge
+    int findEdge(const int from, const int to) const;
+
+private:
+    int m_size = 0;
+    QVector<int> m_rowBegin; // size + 1
+    QVector<int> m_from;
+    QVector<int> m_to;
+    QVector<float> m_weights;
+    QVector<int> m_colBegin; // size + 1
+    QVector<int> m_colEdges;
+};
+
+#endif // SPARSEGRAPH_H
@@ -0,0 +1,36 @@
+QT       += testlib
+QT       -= gui
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_solver
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    tst_solver.cpp \
+    ../branchingstrategy.cpp \
+    ../instancegenerator.cpp \
+    ../matrixkernels.cpp \
+    ../presolve.cpp \
+    ../reductionstate.cpp \
+    ../searchestimator.cpp \
+    ../searchtrace.cpp \
+    ../solverprotocol.cpp \
+    ../sparsegraph.cpp \
+    ../tour.cpp \
+    ../tspsolver.cpp
+
+HEADERS += \
+    ../branchingstrategy.h \
+    ../instancegenerator.h \
+    ../matrixkernels.h \
+    ../presolve.h \
+    ../reductionstate.h \
+    ../searchestimator.h \
+    ../searchtrace.h \
+    ../solverprotocol.h \
+    ../sparsegraph.h \
+    ../tour.h \
+    ../tspsolver.h
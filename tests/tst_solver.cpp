@@ -0,0 +1,440 @@
+#include <QtTest>
+
+#include <algorithm>
+#include <cstring>
+
+#include "instancegenerator.h"
+#include "presolve.h"
+#include "reductionstate.h"
+#include "solverprotocol.h"
+#include "sparsegraph.h"
+#include "tour.h"
+#include "tspsolver.h"
+
+Q_DECLARE_METATYPE(InstanceGenerator::Type)
+Q_DECLARE_METATYPE(BranchingStrategy::Type)
+
+// Generated instances have integer distances, so every engine sums tour lengths exactly
+// and lengths, bounds and matrices are compared bit for bit, not fuzzily.
+class TestSolver : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void protocolFraming();
+    void protocolRequest();
+    void tourBinary();
+    void reductionState_data();
+    void reductionState();
+    void engines_data();
+    void engines();
+    void sparseEngine_data();
+    void sparseEngine();
+    void presolveSoundness_data();
+    void presolveSoundness();
+    void plantedOptimum_data();
+    void plantedOptimum();
+    void cancelFlag();
+
+private:
+    static QVector<float> generate(const InstanceGenerator::Type type, const int size, const quint64 seed);
+    // Planted tour plus extra random paths of every city, far below SparseGraph::sparseDensity
+    static SparseGraph sparseInstance(const int size, const quint64 seed, const int extraPaths);
+    static bool isBitIdentical(const QVector<float> &a, const QVector<float> &b);
+    // Routes by their cities, the engines find them in different order
+    static QVector<QVector<int>> sortedRoutes(const QVector<Tour> &routes);
+    static void addInstanceRows(const QVector<int> &sizes, const int nSeeds);
+};
+
+QVector<float> TestSolver::generate(const InstanceGenerator::Type type, const int size, const quint64 seed)
+{
+    QVector<float> mat;
+    InstanceGenerator(type, size, seed).fillMatrix(mat);
+    return mat;
+}
+
+SparseGraph TestSolver::sparseInstance(const int size, const quint64 seed, const int extraPaths)
+{
+    const InstanceGenerator generator(InstanceGenerator::Type::PLANTED, size, seed);
+    const QVector<int> &tour = generator.plantedTour();
+    QVector<SparseGraph::Edge> edges;
+    for (int i = 0; i < size; ++i) {
+        const int from = tour[i];
+        edges.push_back({from, tour[(i + 1) % size], generator.distance(from, tour[(i + 1) % size])});
+        for (int k = 1; k <= extraPaths; ++k) {
+            const int to = int((quint64(from) * 7919u + quint64(k) * 104729u + seed) % quint64(size));
+            if (to != from)
+                edges.push_back({from, to, generator.distance(from, to)});
+        }
+    }
+    return SparseGraph(size, edges);
+}
+
+bool TestSolver::isBitIdentical(const QVector<float> &a, const QVector<float> &b)
+{
+    return a.size() == b.size() && std::memcmp(a.constData(), b.constData(), size_t(a.size()) * sizeof(float)) == 0;
+}
+
+QVector<QVector<int>> TestSolver::sortedRoutes(const QVector<Tour> &routes)
+{
+    QVector<QVector<int>> cities;
+    for (const Tour &tour : routes)
+        cities.push_back(tour.cities());
+    std::sort(cities.begin(), cities.end());
+    return cities;
+}
+
+void TestSolver::addInstanceRows(const QVector<int> &sizes, const int nSeeds)
+{
+    QTest::addColumn<InstanceGenerator::Type>("type");
+    QTest::addColumn<int>("size");
+    QTest::addColumn<quint64>("seed");
+    for (const InstanceGenerator::Type type : {InstanceGenerator::Type::UNIFORM, InstanceGenerator::Type::EUCLIDEAN,
+                                               InstanceGenerator::Type::CLUSTERED, InstanceGenerator::Type::ROAD,
+                                               InstanceGenerator::Type::PLANTED})
+        for (const int size : sizes)
+            for (int seed = 1; seed <= nSeeds; ++seed)
+                QTest::addRow("%s-%d-%d", qPrintable(InstanceGenerator::typeName(type)), size, seed) << type << size << quint64(seed);
+}
+
+void TestSolver::protocolFraming()
+{
+    QJsonObject first;
+    first.insert("id", 1);
+    QJsonObject second;
+    second.insert("id", "two");
+    const QByteArray stream = SolverProtocol::encodeFrame(first) + SolverProtocol::encodeFrame(second);
+
+    // Byte by byte: nothing is taken before a frame is complete
+    QByteArray buffer;
+    QVector<QJsonObject> objects;
+    for (const char byte : stream) {
+        buffer.append(byte);
+        QJsonObject object;
+        const SolverProtocol::FrameStatus status = SolverProtocol::takeFrame(buffer, object);
+        QVERIFY(status != SolverProtocol::FrameStatus::INVALID);
+        if (status == SolverProtocol::FrameStatus::READY)
+            objects.push_back(object);
+    }
+    QCOMPARE(objects.size(), 2);
+    QCOMPARE(objects[0], first);
+    QCOMPARE(objects[1], second);
+    QVERIFY(buffer.isEmpty());
+
+    // Length above maxFrameSize
+    QByteArray huge(4, Qt::Uninitialized);
+    qToBigEndian<quint32>(SolverProtocol::maxFrameSize + 1u, reinterpret_cast<uchar *>(huge.data()));
+    QJsonObject object;
+    QCOMPARE(SolverProtocol::takeFrame(huge, object), SolverProtocol::FrameStatus::INVALID);
+
+    // Payload which is not a JSON object
+    const QByteArray payload = "[1, 2]";
+    QByteArray array(4, Qt::Uninitialized);
+    qToBigEndian<quint32>(quint32(payload.size()), reinterpret_cast<uchar *>(array.data()));
+    array.append(payload);
+    QCOMPARE(SolverProtocol::takeFrame(array, object), SolverProtocol::FrameStatus::INVALID);
+}
+
+void TestSolver::protocolRequest()
+{
+    const int size = 7;
+    QVector<float> mat = generate(InstanceGenerator::Type::UNIFORM, size, 3);
+    TspSolver::get(mat, size, 2, 5) = -1;
+    const QJsonObject request = SolverProtocol::makeRequest(5, mat, size, AnswerType::ALL, 100, true, BranchingStrategy::Type::STRONG);
+
+    QVector<float> parsedMat;
+    SparseGraph graph;
+    int parsedSize = 0;
+    AnswerType answerType = AnswerType::FIRST;
+    int timeLimitInMs = 0;
+    bool presolve = false;
+    BranchingStrategy::Type branching = BranchingStrategy::Type::MAX_PENALTY;
+    QString error;
+    QVERIFY2(SolverProtocol::parseRequest(request, parsedMat, graph, parsedSize, answerType, timeLimitInMs, presolve, branching, error), qPrintable(error));
+    QCOMPARE(parsedSize, size);
+    QVERIFY(isBitIdentical(parsedMat, mat));
+    QVERIFY(graph.isEmpty());
+    QCOMPARE(answerType, AnswerType::ALL);
+    QCOMPARE(timeLimitInMs, 100);
+    QVERIFY(presolve);
+    QCOMPARE(branching, BranchingStrategy::Type::STRONG);
+
+    // Presolve is opt-in
+    QJsonObject bare = request;
+    bare.remove("presolve");
+    QVERIFY(SolverProtocol::parseRequest(bare, parsedMat, graph, parsedSize, answerType, timeLimitInMs, presolve, branching, error));
+    QVERIFY(!presolve);
+
+    QJsonObject tooBig = request;
+    tooBig.insert("size", SolverProtocol::maxSize + 1);
+    QVERIFY(!SolverProtocol::parseRequest(tooBig, parsedMat, graph, parsedSize, answerType, timeLimitInMs, presolve, branching, error));
+
+    const SparseGraph sparse = sparseInstance(12, 4, 1);
+    const QJsonObject sparseRequest = SolverProtocol::makeRequest(6, sparse, AnswerType::FIRST, 0);
+    QVERIFY2(SolverProtocol::parseRequest(sparseRequest, parsedMat, graph, parsedSize, answerType, timeLimitInMs, presolve, branching, error), qPrintable(error));
+    QVERIFY(parsedMat.isEmpty());
+    QCOMPARE(graph.edgeCount(), sparse.edgeCount());
+    QVector<float> expected;
+    QVector<float> actual;
+    sparse.fillMatrix(expected);
+    graph.fillMatrix(actual);
+    QVERIFY(isBitIdentical(actual, expected));
+}
+
+void TestSolver::tourBinary()
+{
+    const Tour tour = Tour::fromCities({3, 0, 4, 1, 2});
+    QVERIFY(!tour.isEmpty());
+    QCOMPARE(tour.cities(), QVector<int>({0, 4, 1, 2, 3}));
+
+    const QByteArray data = tour.toBinary();
+    QCOMPARE(data.size(), int(sizeof(qint32)) * (tour.size() + 1));
+    QCOMPARE(Tour::fromBinary(data), tour);
+    QCOMPARE(SolverProtocol::tourFromJson(SolverProtocol::tourToJson(tour)), tour);
+    QCOMPARE(Tour::fromPaths(tour.paths(), tour.size()), tour);
+    QCOMPARE(Tour::fromSuccessors(tour.successors()), tour);
+
+    QVERIFY(Tour::fromBinary(data.left(data.size() - 1)).isEmpty());
+    QVERIFY(Tour::fromBinary(QByteArray()).isEmpty());
+    QByteArray repeated = data;
+    qToLittleEndian<qint32>(4, reinterpret_cast<uchar *>(repeated.data()) + 3 * sizeof(qint32)); // 0, 4, 4, 2, 3
+    QVERIFY(Tour::fromBinary(repeated).isEmpty());
+    QVERIFY(Tour::fromCities({0, 1, 1}).isEmpty());
+}
+
+void TestSolver::reductionState_data()
+{
+    addInstanceRows({9, 23}, 2);
+}
+
+void TestSolver::reductionState()
+{
+    QFETCH(InstanceGenerator::Type, type);
+    QFETCH(int, size);
+    QFETCH(quint64, seed);
+
+    // Walks down the branch and bound tree like calcNode: include the pivot, sometimes exclude it instead
+    QVector<float> reference = generate(type, size, seed);
+    QVector<float> mat = reference;
+    ReductionState parent;
+    QVERIFY(parent.reset(mat, size) == TspSolver::simplifyMatrix(reference, size));
+    QVERIFY(isBitIdentical(mat, reference));
+
+    QVector<QPoint> route;
+    for (int step = 0; ; ++step) {
+        QPoint zero;
+        float score = 0.f;
+        QPoint referenceZero;
+        float referenceScore = 0.f;
+        const bool isFound = parent.findPivotZero(zero, score);
+        QCOMPARE(isFound, TspSolver::findPivotZero(reference, size, referenceZero, referenceScore));
+        if (!isFound)
+            break;
+        QCOMPARE(zero, referenceZero);
+        QVERIFY(score == referenceScore);
+
+        const QVector<float> parentMat = mat;
+        ReductionState child;
+        child.copyFrom(parent);
+        const bool isExclude = (step % 3 == 2);
+        float rating = 0.f;
+        if (isExclude) {
+            rating = child.excludePath(mat, zero);
+            TspSolver::get(reference, size, zero.x(), zero.y()) = -1;
+        }
+        else {
+            rating = child.includePath(mat, zero, TspSolver::getSubtourPath(size, zero, route));
+            TspSolver::includePath(reference, size, zero, route);
+            route.push_back(zero);
+        }
+        QVERIFY(rating == TspSolver::simplifyMatrix(reference, size));
+        QVERIFY(isBitIdentical(mat, reference));
+
+        // The parent gets its matrix back
+        QVector<float> restored = mat;
+        child.restore(restored);
+        QVERIFY(isBitIdentical(restored, parentMat));
+
+        parent.copyFrom(child);
+    }
+}
+
+void TestSolver::engines_data()
+{
+    addInstanceRows({6, 8, 9}, 2);
+}
+
+void TestSolver::engines()
+{
+    QFETCH(InstanceGenerator::Type, type);
+    QFETCH(int, size);
+    QFETCH(quint64, seed);
+    const QVector<float> mat = generate(type, size, seed);
+
+    TspSolver bruteForce;
+    const TspSolver::Result expected = bruteForce.solveBruteForce(mat, size, AnswerType::ALL);
+    QVERIFY(expected.hasRoute());
+    const QVector<QVector<int>> expectedRoutes = sortedRoutes(expected.routes);
+
+    for (const BranchingStrategy::Type branching : {BranchingStrategy::Type::MAX_PENALTY, BranchingStrategy::Type::STRONG,
+                                                    BranchingStrategy::Type::MOST_CONSTRAINED}) {
+        for (const bool presolve : {false, true}) {
+            // A logger turns the incremental reduction off
+            for (const bool isLogging : {false, true}) {
+                TspSolver solver;
+                solver.setBranching(branching);
+                solver.setPresolve(presolve);
+                if (isLogging)
+                    solver.setLogger([](const QString &) {});
+                const QByteArray name = BranchingStrategy::typeName(branching).toUtf8()
+                        + (presolve ? " presolve" : "") + (isLogging ? " logging" : "");
+
+                const TspSolver::Result all = solver.solveBranchAndBound(mat, size, AnswerType::ALL);
+                QVERIFY2(all.length == expected.length, name.constData());
+                QVERIFY2(sortedRoutes(all.routes) == expectedRoutes, name.constData());
+                for (const Tour &tour : all.routes)
+                    QVERIFY2(tour.length(mat) == expected.length, name.constData());
+
+                const TspSolver::Result first = solver.solveBranchAndBound(mat, size, AnswerType::FIRST);
+                QVERIFY2(first.length == expected.length, name.constData());
+                QCOMPARE(first.routes.size(), 1);
+                QVERIFY2(expectedRoutes.contains(first.routes.first().cities()), name.constData());
+            }
+        }
+    }
+
+    // Incremental and full reduction build the same tree
+    TspSolver incremental;
+    TspSolver logging;
+    logging.setLogger([](const QString &) {});
+    QCOMPARE(incremental.solveBranchAndBound(mat, size, AnswerType::ALL).nodes,
+             logging.solveBranchAndBound(mat, size, AnswerType::ALL).nodes);
+}
+
+void TestSolver::sparseEngine_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<quint64>("seed");
+    QTest::addColumn<int>("extraPaths");
+    for (const int size : {16, 24, 32})
+        for (int seed = 1; seed <= 4; ++seed)
+            for (const int extraPaths : {1, 2})
+                QTest::addRow("%d-%d-%d", size, seed, extraPaths) << size << quint64(seed) << extraPaths;
+}
+
+void TestSolver::sparseEngine()
+{
+    QFETCH(int, size);
+    QFETCH(quint64, seed);
+    QFETCH(int, extraPaths);
+    const SparseGraph graph = sparseInstance(size, seed, extraPaths);
+    QVERIFY(graph.isSparse());
+    QVector<float> mat;
+    graph.fillMatrix(mat);
+
+    for (const AnswerType answerType : {AnswerType::FIRST, AnswerType::ALL}) {
+        TspSolver sparseSolver;
+        TspSolver matrixSolver;
+        const TspSolver::Result sparse = sparseSolver.solveBranchAndBound(graph, answerType);
+        const TspSolver::Result dense = matrixSolver.solveBranchAndBound(mat, size, answerType);
+        QVERIFY(sparse.isSparse);
+        QVERIFY(!dense.isSparse);
+        QVERIFY(std::memcmp(&sparse.length, &dense.length, sizeof(float)) == 0);
+        QCOMPARE(sparse.nodes, dense.nodes);
+        QCOMPARE(sparse.routes, dense.routes);
+    }
+
+    // Same reduction and pivots on edges as on the matrix
+    QVector<float> weights = graph.weights();
+    QVector<float> reduced = mat;
+    QVERIFY(TspSolver::simplifyEdges(graph, weights) == TspSolver::simplifyMatrix(reduced, size));
+    for (int edge = 0; edge < graph.edgeCount(); ++edge)
+        QVERIFY(weights[edge] == TspSolver::get(reduced, size, graph.from(edge), graph.to(edge)));
+    int edge = -1;
+    float edgeScore = 0.f;
+    QPoint zero;
+    float zeroScore = 0.f;
+    QCOMPARE(TspSolver::findPivotEdge(graph, weights, edge, edgeScore), TspSolver::findPivotZero(reduced, size, zero, zeroScore));
+    if (edge >= 0) {
+        QCOMPARE(QPoint(graph.from(edge), graph.to(edge)), zero);
+        QVERIFY(edgeScore == zeroScore);
+    }
+}
+
+void TestSolver::presolveSoundness_data()
+{
+    addInstanceRows({8, 9}, 3);
+}
+
+void TestSolver::presolveSoundness()
+{
+    QFETCH(InstanceGenerator::Type, type);
+    QFETCH(int, size);
+    QFETCH(quint64, seed);
+    const QVector<float> mat = generate(type, size, seed);
+    TspSolver bruteForce;
+    const TspSolver::Result optimum = bruteForce.solveBruteForce(mat, size, AnswerType::ALL);
+    QVERIFY(optimum.hasRoute());
+
+    // No optimal tour may lose a path, fixed paths are in every one of them
+    QVector<float> presolved = mat;
+    QVector<QPoint> fixedRoute;
+    Tour heuristicTour;
+    const TspSolver::PresolveStatistics statistics = Presolve::run(presolved, size, AnswerType::ALL, fixedRoute, heuristicTour);
+    QVERIFY(statistics.isDone);
+    QVERIFY(statistics.lowerBound <= optimum.length);
+    QVERIFY(statistics.upperBound >= optimum.length);
+    QVERIFY(!heuristicTour.isEmpty());
+    QCOMPARE(heuristicTour.length(mat), statistics.upperBound);
+    for (const Tour &tour : optimum.routes) {
+        for (const QPoint &path : fixedRoute)
+            QCOMPARE(tour.next(path.x()), path.y());
+        for (const QPoint &path : tour.paths())
+            QVERIFY(fixedRoute.contains(path) || TspSolver::get(presolved, size, path.x(), path.y()) >= 0.f);
+    }
+}
+
+void TestSolver::plantedOptimum_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<quint64>("seed");
+    for (const int size : {5, 10, 25, 40})
+        for (int seed = 1; seed <= 3; ++seed)
+            QTest::addRow("%d-%d", size, seed) << size << quint64(seed);
+}
+
+void TestSolver::plantedOptimum()
+{
+    QFETCH(int, size);
+    QFETCH(quint64, seed);
+    const InstanceGenerator generator(InstanceGenerator::Type::PLANTED, size, seed);
+    QVector<float> mat;
+    generator.fillMatrix(mat);
+    const Tour planted = Tour::fromCities(generator.plantedTour());
+    QVERIFY(!planted.isEmpty());
+    QCOMPARE(planted.length(mat), generator.plantedLength());
+
+    for (const bool presolve : {false, true}) {
+        TspSolver solver;
+        solver.setPresolve(presolve);
+        const TspSolver::Result result = solver.solveBranchAndBound(mat, size, AnswerType::ALL);
+        QCOMPARE(result.length, generator.plantedLength());
+        QCOMPARE(result.routes, QVector<Tour>({planted}));
+    }
+}
+
+void TestSolver::cancelFlag()
+{
+    const int size = 60;
+    const QVector<float> mat = generate(InstanceGenerator::Type::UNIFORM, size, 1);
+    const std::atomic<bool> cancel(true);
+    TspSolver solver;
+    solver.setCancelFlag(&cancel);
+    const TspSolver::Result result = solver.solveBranchAndBound(mat, size, AnswerType::ALL);
+    QVERIFY(result.timedOut);
+    QVERIFY(result.nodes <= 1024);
+}
+
+QTEST_GUILESS_MAIN(TestSolver)
+
+#include "tst_solver.moc"
@@ -0,0 +1,140 @@
+#include "tour.h"
+
+#include "tspsolver.h"
+
+#include <QtEndian>
+
+
+Tour Tour::fromSuccessors(const QVector<int> &next)
+{
+    const int size = next.size();
+    QVector<int> cities(size);
+    int city = 0;
+    for (int i = 0; i < size; ++i) {
+        if (city < 0 || city >= size)
+            return Tour();
+        cities[i] = city;
+        city = next[city];
+    }
+    if (city != 0)
+        return Tour();
+    return fromCities(cities);
+}
+
+Tour Tour::fromPaths(const QVector<QPoint> &paths, const int size)
+{
+    if (paths.size() != size)
+        return Tour();
+    QVector<int> next(size, -1);
+    for (const QPoint &path : paths) {
+        if (path.x() < 0 || path.x() >= size || next[path.x()] >= 0)
+            return Tour();
+        next[path.x()] = path.y();
+    }
+    return fromSuccessors(next);
+}
+
+Tour Tour::fromCities(const QVector<int> &cities)
+{
+    const int size = cities.size();
+    Tour tour;
+    tour.m_positions.fill(-1, size);
+    int start = 0;
+    for (int i = 0; i < size; ++i) {
+        const int city = cities[i];
+        if (city < 0 || city >= size || tour.m_positions[city] >= 0)
+            return Tour();
+        tour.m_positions[city] = i;
+        if (city == 0)
+            start = i;
+    }
+    // Rotate to start from city 0
+    tour.m_cities.resize(size);
+    for (int i = 0; i < size; ++i) {
+        const int city = cities[start + i < size ? start + i : start + i - size];
+        tour.m_cities[i] = city;
+        tour.m_positions[city] = i;
+    }
+    return tour;
+}
+
+int Tour::next(const int city) const
+{
+    const int position = m_positions[city] + 1;
+    return m_cities[position == m_cities.size() ? 0 : position];
+}
+
+int Tour::prev(const int city) const
+{
+    const int position = m_positions[city];
+    return m_cities[position == 0 ? m_cities.size() - 1 : position - 1];
+}
+
+QVector<int> Tour::successors() const
+{
+    const int size = m_cities.size();
+    QVector<int> next(size);
+    for (int i = 0; i < size; ++i)
+        next[m_cities[i]] = m_cities[i + 1 < size ? i + 1 : 0];
+    return next;
+}
+
+QVector<QPoint> Tour::paths() const
+{
+    const int size = m_cities.size();
+    QVector<QPoint> paths(size);
+    for (int i = 0; i < size; ++i)
+        paths[i] = QPoint(m_cities[i], m_cities[i + 1 < size ? i + 1 : 0]);
+    return paths;
+}
+
+float Tour::length(const QVector<float> &mat) const
+{
+    const int size = m_cities.size();
+    float length = 0.f;
+    for (int i = 0; i < size; ++i)
+        length += TspSolver::get(mat, size, m_cities[i], m_cities[i + 1 < size ? i + 1 : 0]);
+    return length;
+}
+
+QString Tour::toString() const
+{
+    const int size = m_cities.size();
+    if (size == 0)
+        return "{Empty}\n";
+    QString result;
+    result.reserve(size * 10 + 4);
+    result += '{';
+    for (int i = 0; i < size; ++i) {
+        result += QString::number(m_cities[i]);
+        result += "->";
+        result += QString::number(m_cities[i + 1 < size ? i + 1 : 0]);
+        result += i + 1 < size ? ", " : "}\n";
+    }
+    return result;
+}
+
+QByteArray Tour::toBinary() const
+{
+    const int size = m_cities.size();
+    QByteArray data(4 * (size + 1), Qt::Uninitialized);
+    uchar *out = reinterpret_cast<uchar *>(data.data());
+    qToLittleEndian<qint32>(size, out);
+    for (int i = 0; i < size; ++i)
+        qToLittleEndian<qint32>(m_cities[i], out + 4 * (i + 1));
+    return data;
+}
+
+Tour Tour::fromBinary(const QByteArray &data)
+{
+    if (data.size() < 4)
+        return Tour();
+    const uchar *in = reinterpret_cast<const uchar *>(data.constData());
+    const qint32 size = qFromLittleEndian<qint32>(in);
+    if (size < 0 || data.size() != 4 * (qint64(size) + 1))
+        return Tour();
+    QVector<int> cities(size);
+    for (int i = 0; i < size; ++i)
+        cities[i] = qFromLittleEndian<qint32>(in + 4 * (i + 1));
+    return fromCities(cities);
+}
@@ -0,0 +1,51 @@
+#ifndef TOUR_H
+#define TOUR_H
+
+#include <QByteArray>
+#include <QPoint>
+#include <QString>
+#include <QVector>
+
+// Closed route through every city. Cities are kept in route order starting
+// from city 0 together with the position of every city, so a tour has one
+// representation (equal tours compare equal) and the successor, predecessor
+// and position of a city are O(1).
+class Tour
+{
+public:
+    Tour() = default;
+    // next[city] is the city after city. Empty tour if next is not a single cycle through every city
+    static Tour fromSuccessors(const QVector<int> &next);
+    // Paths in any order, O(size). Empty tour if they are not a single cycle through size cities
+    static Tour fromPaths(const QVector<QPoint> &paths, const int size);
+    // Cities in route order starting from any of them. Empty tour if a city is missing or repeated
+    static Tour fromCities(const QVector<int> &cities);
+
+    bool isEmpty() const { return m_cities.isEmpty(); }
+    int size() const { return m_cities.size(); }
+    // Cities in route order from city 0
+    const QVector<int> &cities() const { return m_cities; }
+    int position(const int city) const { return m_positions[city]; }
+    int next(const int city) const;
+    int prev(const int city) const;
+    QVector<int> successors() const;
+    // Paths in route order from city 0
+    QVector<QPoint> paths() const;
+    float length(const QVector<float> &mat) const;
+
+    // "{0->2, 2->1, 1->0}\n", the format of TspSolver::getRouteString
+    QString toString() const;
+    // Number of cities and the cities from city 0, little-endian 32 bit integers
+    QByteArray toBinary() const;
+    // Empty tour if data is not a valid tour
+    static Tour fromBinary(const QByteArray &data);
+
+    bool operator==(const Tour &other) const { return m_cities == other.m_cities; }
+    bool operator!=(const Tour &other) const { return m_cities != other.m_cities; }
+
+private:
+    QVector<int> m_cities;
+    QVector<int> m_positions;
+};
+
+#endif // TOUR_H
@@ -0,0 +1,991 @@
+#include "tspsolver.h"
+
+#include "matrixkernels.h"
+#include "presolve.h"
+
+#include <algorithm>
+
+TspSolver::Result TspSolver::solveBranchAndBound(
+        const QVector<float> &mat,
+        const int size,
+        const AnswerType answerType)
+{
+    Result result;
+    startClock();
+    if (!m_presolve) {
+        calcNode(mat, size, 0, QVector<QPoint>(), 0.f, result.length, result.routes, true, answerType);
+        finishResult(result);
+        return result;
+    }
+
+    m_presolveBuffer = mat;
+    if (size >= MatrixKernels::parallelSize)
+        MatrixKernels::adviseHugePages(m_presolveBuffer.data(), size_t(m_presolveBuffer.size()) * sizeof(float));
+    QVector<QPoint> fixedRoute;
+    Tour heuristicTour;
+    result.presolve = Presolve::run(m_presolveBuffer, size, answerType, fixedRoute, heuristicTour);
+    if (isLogging())
+        addLog(getPresolveString(result.presolve) + "\n");
+    if (!heuristicTour.isEmpty()) {
+        result.length = result.presolve.upperBound;
+        if (answerType == AnswerType::FIRST)
+            result.routes = {heuristicTour};
+        else // Equal tours are searched again, their bound sums may round above the heuristic length
+            result.length += Presolve::tolerance(result.presolve.upperBound);
+    }
+    if (!result.presolve.isExhausted) {
+        float fixedRating = 0.f;
+        for (const QPoint &path : fixedRoute)
+            fixedRating += get(mat, size, path.x(), path.y());
+        calcNode(m_presolveBuffer, size, 0, fixedRoute, fixedRating, result.length, result.routes, true, answerType);
+    }
+    if (answerType == AnswerType::ALL && !heuristicTour.isEmpty() && result.routes.isEmpty()) { // Nothing searched or found in time
+        result.length = result.presolve.upperBound;
+        result.routes = {heuristicTour};
+    }
+    finishResult(result);
+    return result;
+}
+
+TspSolver::Result TspSolver::solveBruteForce(
+        const QVector<float> &mat,
+        const int size,
+        const AnswerType answerType)
+{
+    Result result;
+    startClock();
+    bruteForceCalc(mat, size, {}, 0.f, result.length, result.routes, answerType);
+    finishResult(result);
+    return result;
+}
+
+TspSolver::Result TspSolver::solveSubproblem(
+        const QVector<float> &mat,
+        const int size,
+        const Subproblem &subproblem,
+        const AnswerType answerType,
+        const float incumbent)
+{
+    Result result;
+    result.length = incumbent;
+    startClock();
+    QVector<float> subMat;
+    const float includedRating = applySubproblem(mat, size, subproblem, subMat);
+    m_excludedPaths = subproblem.excluded;
+    calcNode(subMat, size, 0, subproblem.included, includedRating, result.length, result.routes, true, answerType);
+    finishResult(result);
+    return result;
+}
+
+TspSolver::Result TspSolver::solveBranchAndBound(const SparseGraph &graph, const AnswerType answerType)
+{
+    if (!graph.isSparse() || m_branching->type() != BranchingStrategy::Type::MAX_PENALTY) {
+        QVector<float> mat;
+        graph.fillMatrix(mat);
+        return solveBranchAndBound(mat, graph.size(), answerType);
+    }
+
+    Result result;
+    startClock();
+    calcSparseNode(graph, graph.weights(), 0, QVector<QPoint>(), 0.f, result.length, result.routes, true, answerType);
+    finishResult(result);
+    result.isSparse = true;
+    return result;
+}
+
+QVector<TspSolver::Subproblem> TspSolver::splitProblem(
+        const QVector<float> &mat,
+        const int size,
+        const Subproblem &root,
+        const int count,
+        const AnswerType answerType,
+        float &bestRating,
+        QVector<Tour> &bestRoutes)
+{
+    QVector<Subproblem> open = {root};
+    QVector<float> subMat;
+    while (!open.isEmpty() && open.size() < count) {
+        // Split the subproblem with the lowest bound
+        int bestIndex = 0;
+        for (int i = 1; i < open.size(); ++i)
+            if (open[i].bound < open[bestIndex].bound)
+                bestIndex = i;
+        const Subproblem subproblem = open[bestIndex];
+        open.remove(bestIndex);
+
+        const float rating = applySubproblem(mat, size, subproblem, subMat) + simplifyMatrix(subMat, size);
+        if (isWorseThanRecord(rating, bestRating, answerType))
+            continue;
+        QPoint zeroPos;
+        float score = 0.f;
+        if (!findPivotZero(subMat, size, zeroPos, score)) {
+            if (subproblem.included.size() != size)
+                continue;
+            if (rating < bestRating) {
+                bestRating = rating;
+                bestRoutes = {Tour::fromPaths(subproblem.included, size)};
+            }
+            else if (answerType == AnswerType::ALL)
+                bestRoutes.push_back(Tour::fromPaths(subproblem.included, size));
+            continue;
+        }
+
+        Subproblem includeChild = subproblem;
+        includeChild.included.push_back(zeroPos);
+        includeChild.bound = rating;
+        open.push_back(includeChild);
+        Subproblem excludeChild = subproblem;
+        excludeChild.excluded.push_back(zeroPos);
+        excludeChild.bound = rating + score;
+        open.push_back(excludeChild);
+    }
+
+    QVector<Subproblem> result;
+    for (const Subproblem &subproblem : open)
+        if (!isWorseThanRecord(subproblem.bound, bestRating, answerType))
+            result.push_back(subproblem);
+    return result;
+}
+
+float TspSolver::applySubproblem(
+        const QVector<float> &mat,
+        const int size,
+        const Subproblem &subproblem,
+        QVector<float> &subMat)
+{
+    subMat = mat;
+    float includedRating = 0.f;
+    QVector<QPoint> route;
+    route.reserve(subproblem.included.size());
+    for (const QPoint &path : subproblem.included) { // Same order as in the tree, so subtours are removed the same way
+        includedRating += get(mat, size, path.x(), path.y());
+        includePath(subMat, size, path, route);
+        route.push_back(path);
+    }
+    for (const QPoint &path : subproblem.excluded)
+        get(subMat, size, path.x(), path.y()) = -1;
+    return includedRating;
+}
+
+bool TspSolver::isWorseThanRecord(const float rating, const float bestRating, const AnswerType answerType)
+{
+    if (answerType == AnswerType::ALL)
+        return bestRating < rating;
+    return bestRating <= rating;
+}
+
+QString TspSolver::getConvertedTime(const size_t timeInNs)
+{
+    const size_t timeInMs = timeInNs / 1000000ull;
+    const size_t timeInSeconds = timeInMs / 1000;
+    const size_t timeInMinutes = timeInSeconds / 60;
+    const size_t timeInHours = timeInMinutes / 60;
+    const size_t ns = timeInNs % 1000000ull;
+    const size_t ms = timeInMs % 1000;
+    const size_t sec = timeInSeconds % 60;
+    const size_t min = timeInMinutes % 60;
+    const size_t hrs = timeInHours;
+
+    QString result;
+    if (hrs > 0)
+        result += QString::number(hrs) + "h, ";
+    if (min > 0)
+        result += QString::number(min) + "min, ";
+    if (sec > 0)
+        result += QString::number(sec) + "sec, ";
+    if (ms > 0)
+        result += QString::number(ms) + "ms, ";
+    result += QString::number(ns) + "ns";
+
+    return result;
+}
+
+QString TspSolver::getMatrixString(const QVector<float> &mat, const int size)
+{
+    const int floatPrecision = 3;
+    const int valueWith = 10;
+    QString result;
+    result += QString("   ");
+    for (int col = 0; col < size; ++col)
+        result += QString("%1 ").arg(col, valueWith);
+    result += "\n";
+    for (int row = 0; row < size; ++row) {
+        result += QString("%1|").arg(row, 3);
+        for (int col = 0; col < size; ++col) {
+            if (get(mat, size, row, col) < 0.f) {
+                result += QString("%1 ").arg("X", valueWith);
+                continue;
+            }
+
+            result += QString("%1 ").arg(get(mat, size, row, col), valueWith, 'g', floatPrecision);
+        }
+        result += QString("|\n");
+    }
+    return result;
+}
+
+QString TspSolver::getRouteString(const QVector<QPoint> &route)
+{
+    const int size = route.size();
+    if (size == 0)
+        return "{Empty}\n";
+    QString result;
+    result.reserve(size * 10 + 4);
+    result += '{';
+    for (int i = 0; i < size; ++i) {
+        result += QString::number(route[i].x());
+        result += "->";
+        result += QString::number(route[i].y());
+        result += i + 1 < size ? ", " : "}\n";
+    }
+    return result;
+}
+
+QString TspSolver::getEstimateString(const SearchEstimator::Estimate &estimate)
+{
+    QString result = QString("Nodes %1").arg(estimate.nodes);
+    if (estimate.totalNodes > 0.)
+        result += QString(" of ~%1").arg(estimate.totalNodes, 0, 'g', 3);
+    if (estimate.gap >= 0.f)
+        result += QString(", bounds %1..%2, gap %3%").arg(estimate.lowerBound).arg(estimate.upperBound).arg(100. * estimate.gap, 0, 'f', 2);
+    else
+        result += QString(", lower bound %1, no tour yet").arg(estimate.lowerBound);
+    if (estimate.remainingInNs >= 0)
+        result += QString(", remaining ~%1").arg(getConvertedTime(size_t(estimate.remainingInNs)));
+    return result;
+}
+
+QString TspSolver::getPresolveString(const PresolveStatistics &statistics)
+{
+    QString result = QString("Предобработка: удалено путей %1 из %2, зафиксировано %3, нижняя оценка %4")
+            .arg(statistics.nRemoved).arg(statistics.nEdges).arg(statistics.nFixed).arg(statistics.lowerBound);
+    if (statistics.upperBound != std::numeric_limits<float>::max())
+        result += QString(", эвристический маршрут %1").arg(statistics.upperBound);
+    result += QString(", время %1").arg(getConvertedTime(statistics.timeInNs));
+    return result;
+}
+
+void TspSolver::fillPenalties(
+        const QVector<float> &mat,
+        const int size,
+        QVector<float> &rowScore,
+        QVector<float> &colScore)
+{
+    rowScore.resize(size);
+    colScore.resize(size);
+    MatrixKernels::penalties(mat.constData(), size, rowScore.data(), colScore.data());
+}
+
+bool TspSolver::findPivotZero(
+        const QVector<float> &mat,
+        const int size,
+        QPoint &zeroPos,
+        float &score)
+{
+    QVector<float> rowScore;
+    QVector<float> colScore;
+    fillPenalties(mat, size, rowScore, colScore);
+
+    float bestScore = -1.f;
+    QPoint resPos = QPoint(0, 0);
+    for (int col = 0; col < size; ++col)
+        for (int row = 0; row < size; ++row) {
+            const float value = get(mat, size, row, col);
+            if (qFuzzyIsNull(value)) {
+                const float score = rowScore[row] + colScore[col];
+                if (score > bestScore) {
+                    bestScore = score;
+                    resPos = QPoint(row, col);
+                }
+            }
+        }
+
+    zeroPos = resPos;
+    score = bestScore;
+
+    if (bestScore < 0.f)
+        return false;
+
+    return true;
+}
+
+void TspSolver::includePath(
+        QVector<float> &mat,
+        const int size,
+        const QPoint &newPath,
+        const QVector<QPoint> &currentRoute)
+{
+    for (int row = 0; row < size; ++row){
+        get(mat, size, row, newPath.y()) = -1;
+    }
+    for (int col = 0; col < size; ++col){
+        get(mat, size, newPath.x(), col) = -1;
+    }
+
+    const QPoint subtourPath = getSubtourPath(size, newPath, currentRoute);
+    if (subtourPath.x() >= 0)
+        get(mat, size, subtourPath.x(), subtourPath.y()) = -1;
+}
+
+QPoint TspSolver::getSubtourPath(const int size, const QPoint &newPath, const QVector<QPoint> &currentRoute)
+{
+    const int nRoutes = currentRoute.size();
+    if (nRoutes == size - 2) // Не удаляем подцикл если следующтй путь последний
+        return QPoint(-1, -1);
+    int beginCurrentPath = newPath.x();
+    int endCurrentPath = newPath.y();
+    bool done = false;
+    while (!done) {// Удаляем подциклы
+        done = true;
+        for (int r = 0; r < nRoutes; ++r) {
+            const int endPartPath = currentRoute[r].y();
+            if (beginCurrentPath == endPartPath) {
+                beginCurrentPath = currentRoute[r].x();
+                done = false;
+                break;
+            }
+        }
+        for (int r = 0; r < nRoutes; ++r) {
+            const int beginPartPath = currentRoute[r].x();
+            if (endCurrentPath == beginPartPath) {
+                endCurrentPath = currentRoute[r].y();
+                done = false;
+                break;
+            }
+        }
+    }
+    return QPoint(endCurrentPath, beginCurrentPath);
+}
+
+float TspSolver::simplifyMatrix(QVector<float> &mat, const int size)
+{
+    return MatrixKernels::reduce(mat.data(), size);
+}
+
+float TspSolver::simplifyEdges(const SparseGraph &graph, QVector<float> &weights)
+{
+    const int size = graph.size();
+    float result = 0.f;
+    for (int row = 0; row < size; ++row) {
+        const int end = graph.rowBegin(row + 1);
+        float minValue = std::numeric_limits<float>::max();
+        for (int edge = graph.rowBegin(row); edge < end; ++edge)
+            if (weights[edge] >= 0.f && weights[edge] < minValue)
+                minValue = weights[edge];
+        if (minValue == std::numeric_limits<float>::max())
+            continue;
+        for (int edge = graph.rowBegin(row); edge < end; ++edge)
+            if (weights[edge] >= 0.f)
+                weights[edge] -= minValue;
+        result += minValue;
+    }
+
+    for (int col = 0; col < size; ++col) {
+        const int end = graph.colBegin(col + 1);
+        float minValue = std::numeric_limits<float>::max();
+        for (int i = graph.colBegin(col); i < end; ++i) {
+            const float value = weights[graph.colEdge(i)];
+            if (value >= 0.f && value < minValue)
+                minValue = value;
+        }
+        if (minValue == std::numeric_limits<float>::max())
+            continue;
+        for (int i = graph.colBegin(col); i < end; ++i) {
+            float &value = weights[graph.colEdge(i)];
+            if (value >= 0.f)
+                value -= minValue;
+        }
+        result += minValue;
+    }
+    return result;
+}
+
+bool TspSolver::findPivotEdge(const SparseGraph &graph, const QVector<float> &weights, int &edge, float &score)
+{
+    const int size = graph.size();
+    // Line minimum without one of its zeros, as in fillPenalties
+    const auto penalty = [](float &minValue, bool &hasZero, const float value) {
+        if (value < 0.f)
+            return;
+        if (!hasZero && qFuzzyIsNull(value)) {
+            hasZero = true;
+            return;
+        }
+        if (value < minValue)
+            minValue = value;
+    };
+    QVector<float> rowScore(size);
+    QVector<float> colScore(size);
+    for (int row = 0; row < size; ++row) {
+        float minValue = std::numeric_limits<float>::max();
+        bool hasZero = false;
+        for (int e = graph.rowBegin(row); e < graph.rowBegin(row + 1); ++e)
+            penalty(minValue, hasZero, weights[e]);
+        rowScore[row] = minValue == std::numeric_limits<float>::max() ? 0.f : minValue;
+    }
+    for (int col = 0; col < size; ++col) {
+        float minValue = std::numeric_limits<float>::max();
+        bool hasZero = false;
+        for (int i = graph.colBegin(col); i < graph.colBegin(col + 1); ++i)
+            penalty(minValue, hasZero, weights[graph.colEdge(i)]);
+        colScore[col] = minValue == std::numeric_limits<float>::max() ? 0.f : minValue;
+    }
+
+    // Column by column, rows in order: ties go to the same zero as in findPivotZero
+    float bestScore = -1.f;
+    for (int col = 0; col < size; ++col)
+        for (int i = graph.colBegin(col); i < graph.colBegin(col + 1); ++i) {
+            const int e = graph.colEdge(i);
+            if (!qFuzzyIsNull(weights[e]))
+                continue;
+            const float zeroScore = rowScore[graph.from(e)] + colScore[col];
+            if (zeroScore > bestScore) {
+                bestScore = zeroScore;
+                edge = e;
+            }
+        }
+    score = bestScore;
+    return bestScore >= 0.f;
+}
+
+void TspSolver::includeEdge(
+        const SparseGraph &graph,
+        QVector<float> &weights,
+        const int edge,
+        const QVector<QPoint> &currentRoute)
+{
+    const int from = graph.from(edge);
+    const int to = graph.to(edge);
+    for (int e = graph.rowBegin(from); e < graph.rowBegin(from + 1); ++e)
+        weights[e] = -1;
+    for (int i = graph.colBegin(to); i < graph.colBegin(to + 1); ++i)
+        weights[graph.colEdge(i)] = -1;
+
+    const QPoint subtourPath = getSubtourPath(graph.size(), QPoint(from, to), currentRoute);
+    if (subtourPath.x() < 0)
+        return;
+    const int subtourEdge = graph.findEdge(subtourPath.x(), subtourPath.y());
+    if (subtourEdge >= 0)
+        weights[subtourEdge] = -1;
+}
+
+void TspSolver::calcNode(
+        const QVector<float> &inputMat,
+        const int size,
+        const int depth,
+        const QVector<QPoint> &currentRoute,
+        const float beforeSimplifyRating, // Оценка текущей ноды до приведения
+        float &bestRating,
+        QVector<Tour> &bestRoute,
+        const bool needToSimplify,
+        const AnswerType answerType)
+{
+    if (isTimeOver())
+        return;
+    if (m_nodeLimit != 0 && m_nodes >= m_nodeLimit) { // Leave the node to whoever split the work
+        m_openSubproblems.push_back({currentRoute, m_excludedPaths, beforeSimplifyRating});
+        return;
+    }
+    ++m_nodes;
+    const TraceScope traceScope = {*this, beginTraceNode(depth, currentRoute, beforeSimplifyRating, !needToSimplify), m_traceNode};
+    m_traceNode = traceScope.node;
+    if (m_sharedBound != nullptr) {
+        const float sharedRating = m_sharedBound->load(std::memory_order_relaxed);
+        if (sharedRating < bestRating) { // Record of someone else is better than ours
+            bestRating = sharedRating;
+            bestRoute.clear();
+        }
+    }
+    if (m_estimator != nullptr) {
+        if (depth == 0) {
+            m_probeMat = inputMat;
+            m_probeRoute = currentRoute;
+            m_probeRating = beforeSimplifyRating;
+            m_probeSize = size;
+        }
+        if ((m_nodes & 0xff) == 1) // Clock is read once per 256 nodes
+            updateEstimate(beforeSimplifyRating, bestRating, answerType);
+    }
+
+    if (isLogging()) {
+        addLog("\n");
+        addLog("\n");
+        addLog("Текущий маршрут:");
+        addLog(getRouteString(currentRoute));
+        addLog("Текущая матрица:\n");
+        addLog(getMatrixString(inputMat, size));
+    }
+    // The log shows the matrix of every child, so only without it children are incremental.
+    // Incremental nodes below the root change the root buffer in place and restore it on return.
+    ReductionState *reduction = isLogging() ? nullptr : &reductionState(depth);
+    const bool isInPlace = reduction != nullptr && depth > 0;
+    QVector<float> &mat = isInPlace ? m_nodeBuffers[0] : nodeBuffer(m_nodeBuffers, depth, size * size);
+    if (!isInPlace)
+        std::copy(inputMat.constData(), inputMat.constData() + size * size, mat.data());
+    const RestoreScope restoreScope = {isInPlace ? reduction : nullptr, mat};
+    float simplifyRating = 0.f;
+    if (reduction == nullptr)
+        simplifyRating = simplifyMatrix(mat, size);
+    else if (depth == 0)
+        simplifyRating = reduction->reset(mat, size);
+    else {
+        reduction->copyFrom(m_reductions[depth - 1]);
+        simplifyRating = needToSimplify
+                ? reduction->includePath(mat, currentRoute.last(), m_subtourPath)
+                : reduction->excludePath(mat, m_excludedPaths.last());
+    }
+    if (!needToSimplify)
+        simplifyRating = 0.f;
+    const float currentRating = simplifyRating + beforeSimplifyRating;
+    if (traceScope.node != SearchTrace::noNode)
+        m_trace->setBound(traceScope.node, currentRating);
+    if (isLogging()) {
+        if (simplifyRating > 0.f) {
+            addLog("Приведёная матрица:\n");
+            addLog(getMatrixString(mat, size));
+            addLog(QString("Оценка после приведения: %1 + %2 = %3\n").arg(beforeSimplifyRating).arg(simplifyRating).arg(currentRating));
+        }
+        else {
+            if (needToSimplify)
+                addLog(QString("Матрица уже приведёная, оценка не изменилась: %1\n").arg(currentRating));
+            else
+                addLog(QString("При исключении пути приведение не требуется, оценка не изменилась: %1\n").arg(currentRating));
+        }
+    }
+    const bool hasRecord = (bestRating != std::numeric_limits<float>::max());
+    if (hasRecord) { // Если уже есть рекорд
+        if (answerType == AnswerType::FIRST && bestRating <= currentRating) {
+            if (isLogging())
+                addLog(QString("Оценка хуже или равна текущему рекорду: %1 <= %2; Закрытие ветки.\n").arg(bestRating).arg(currentRating));
+            setTraceOutcome(traceScope.node, SearchTrace::Outcome::PRUNED);
+            return;
+        }
+        else if (answerType == AnswerType::ALL && bestRating < currentRating) {
+            if (isLogging())
+                addLog(QString("Оценка хуже текущего рекорда: %1 < %2; Закрытие ветки.\n").arg(bestRating).arg(currentRating));
+            setTraceOutcome(traceScope.node, SearchTrace::Outcome::PRUNED);
+            return;
+        }
+    }
+
+    QPoint zeroPos;
+    float score = 0.f;
+    const bool isFounded = reduction != nullptr && m_branching->type() == BranchingStrategy::Type::MAX_PENALTY
+            ? reduction->findPivotZero(zeroPos, score)
+            : m_branching->choose(mat, size, currentRoute, zeroPos, score);
+    if (!isFounded) {
+        finishBranch(size, currentRoute, currentRating, bestRating, bestRoute, answerType, traceScope.node);
+        return;
+    }
+    setTraceOutcome(traceScope.node, SearchTrace::Outcome::BRANCHED);
+    if (isLogging())
+        addLog(QString("Включаем в маршрут путь %1->%2\n").arg(zeroPos.x()).arg(zeroPos.y()));
+    QVector<QPoint> newRoute = currentRoute;
+    newRoute.push_back(zeroPos);
+    const QVector<float> *childMat = &mat;
+    if (reduction == nullptr) {
+        QVector<float> &newMat = nodeBuffer(m_childBuffers, depth, size * size);
+        std::copy(mat.constData(), mat.constData() + size * size, newMat.data());
+        includePath(newMat, size, zeroPos, currentRoute);
+        childMat = &newMat;
+    }
+    else
+        m_subtourPath = getSubtourPath(size, zeroPos, currentRoute);
+    const float secondRating = currentRating + score;
+    if (m_estimator != nullptr)
+        m_openBounds.push_back(secondRating);
+    calcNode(*childMat, size, depth + 1, newRoute, currentRating, bestRating, bestRoute, true, answerType);
+    if (m_estimator != nullptr)
+        m_openBounds.removeLast();
+    if (isLogging()) {
+        addLog("\n");
+        addLog("\n");
+        addLog("Возврат к маршруту:");
+        addLog(getRouteString(currentRoute));
+        addLog(QString("Исключаем из маршрута путь %1->%2; Оценка после исключения: %3 + %4 = %5\n").arg(zeroPos.x()).arg(zeroPos.y()).arg(currentRating).arg(score).arg(secondRating));
+    }
+    const bool hasRecordNow = (bestRating != std::numeric_limits<float>::max());
+    if (hasRecordNow) { // Если уже есть рекорд
+        if (answerType == AnswerType::FIRST && bestRating <= secondRating) {
+            if (isLogging())
+                addLog(QString("Оценка хуже или равна текущему рекорду: %1 <= %2; Закрытие ветки.\n").arg(bestRating).arg(secondRating));
+            return;
+        }
+        else if (answerType == AnswerType::ALL && bestRating < secondRating) {
+            if (isLogging())
+                addLog(QString("Оценка хуже текущего рекорда: %1 < %2; Закрытие ветки.\n").arg(bestRating).arg(secondRating));
+            return;
+        }
+    }
+    if (reduction == nullptr)
+        get(mat, size, zeroPos.x(), zeroPos.y()) = -1;
+    m_excludedPaths.push_back(zeroPos);
+    calcNode(mat, size, depth + 1, currentRoute, secondRating, bestRating, bestRoute, false, answerType);
+    m_excludedPaths.removeLast();
+}
+
+void TspSolver::calcSparseNode(
+        const SparseGraph &graph,
+        const QVector<float> &inputWeights,
+        const int depth,
+        const QVector<QPoint> &currentRoute,
+        const float beforeSimplifyRating,
+        float &bestRating,
+        QVector<Tour> &bestRoute,
+        const bool needToSimplify,
+        const AnswerType answerType)
+{
+    if (isTimeOver())
+        return;
+    if (m_nodeLimit != 0 && m_nodes >= m_nodeLimit) {
+        m_openSubproblems.push_back({currentRoute, m_excludedPaths, beforeSimplifyRating});
+        return;
+    }
+    ++m_nodes;
+    const TraceScope traceScope = {*this, beginTraceNode(depth, currentRoute, beforeSimplifyRating, !needToSimplify), m_traceNode};
+    m_traceNode = traceScope.node;
+    if (m_sharedBound != nullptr) {
+        const float sharedRating = m_sharedBound->load(std::memory_order_relaxed);
+        if (sharedRating < bestRating) {
+            bestRating = sharedRating;
+            bestRoute.clear();
+        }
+    }
+
+    const int nEdges = graph.edgeCount();
+    QVector<float> &weights = nodeBuffer(m_nodeBuffers, depth, nEdges);
+    std::copy(inputWeights.constData(), inputWeights.constData() + nEdges, weights.data());
+    float simplifyRating = simplifyEdges(graph, weights);
+    if (!needToSimplify)
+        simplifyRating = 0.f;
+    const float currentRating = simplifyRating + beforeSimplifyRating;
+    if (traceScope.node != SearchTrace::noNode)
+        m_trace->setBound(traceScope.node, currentRating);
+    if (isWorseThanRecord(currentRating, bestRating, answerType)) {
+        setTraceOutcome(traceScope.node, SearchTrace::Outcome::PRUNED);
+        return;
+    }
+
+    int edge = -1;
+    float score = 0.f;
+    if (!findPivotEdge(graph, weights, edge, score)) {
+        finishBranch(graph.size(), currentRoute, currentRating, bestRating, bestRoute, answerType, traceScope.node);
+        return;
+    }
+    setTraceOutcome(traceScope.node, SearchTrace::Outcome::BRANCHED);
+    const QPoint zeroPos(graph.from(edge), graph.to(edge));
+    QVector<QPoint> newRoute = currentRoute;
+    newRoute.push_back(zeroPos);
+    QVector<float> &newWeights = nodeBuffer(m_childBuffers, depth, nEdges);
+    std::copy(weights.constData(), weights.constData() + nEdges, newWeights.data());
+    includeEdge(graph, newWeights, edge, currentRoute);
+    calcSparseNode(graph, newWeights, depth + 1, newRoute, currentRating, bestRating, bestRoute, true, answerType);
+
+    const float secondRating = currentRating + score;
+    if (isWorseThanRecord(secondRating, bestRating, answerType))
+        return;
+    weights[edge] = -1;
+    m_excludedPaths.push_back(zeroPos);
+    calcSparseNode(graph, weights, depth + 1, currentRoute, secondRating, bestRating, bestRoute, false, answerType);
+    m_excludedPaths.removeLast();
+}
+
+void TspSolver::finishBranch(
+        const int size,
+        const QVector<QPoint> &currentRoute,
+        const float currentRating,
+        float &bestRating,
+        QVector<Tour> &bestRoute,
+        const AnswerType answerType,
+        const quint32 traceNode)
+{
+    const bool isAnswer = currentRoute.size() == size;
+    if (!isAnswer) {
+        addLog("Доступные пути кончились, решение не получено; Закрытие ветки.\n");
+        setTraceOutcome(traceNode, SearchTrace::Outcome::DEAD_END);
+        return;
+    }
+    setTraceOutcome(traceNode, SearchTrace::Outcome::SOLUTION);
+    if (answerType == AnswerType::FIRST && bestRating > currentRating) {
+        const Tour tour = Tour::fromPaths(currentRoute, size);
+        if (isLogging())
+            addLog(QString("Новый рекорд: %1; Рекордный путь: %2").arg(currentRating).arg(tour.toString()));
+        bestRating = currentRating;
+        bestRoute = {tour};
+        if (m_recordCallback)
+            m_recordCallback(currentRating, tour);
+        setTraceOutcome(traceNode, SearchTrace::Outcome::RECORD);
+    }
+    else if (answerType == AnswerType::ALL && bestRating >= currentRating) {
+        const bool newRecord = bestRating > currentRating;
+        const Tour tour = Tour::fromPaths(currentRoute, size);
+        if (newRecord) {
+            if (isLogging())
+                addLog(QString("Новый рекорд: %1; Рекордный путь: %2").arg(currentRating).arg(tour.toString()));
+            bestRating = currentRating;
+            bestRoute = {tour};
+            if (m_recordCallback)
+                m_recordCallback(currentRating, tour);
+            setTraceOutcome(traceNode, SearchTrace::Outcome::RECORD);
+        }
+        else {
+            if (isLogging())
+                addLog(QString("Получен старый рекорд: %1; Добавлен путь: %2").arg(currentRating).arg(tour.toString()));
+            bestRating = currentRating;
+            bestRoute.push_back(tour);
+        }
+    }
+    else if (isLogging()) {
+        addLog(QString("Получено решение: %1; Полученый путь: %2").arg(currentRating).arg(getRouteString(currentRoute)));
+        addLog(QString("Полученное решение хуже или равно текущему рекорду: %1 <= %2; Закрытие ветки.\n").arg(bestRating).arg(currentRating));
+    }
+}
+
+void TspSolver::bruteForceCalc(
+        const QVector<float> &mat,
+        const int size,
+        const QVector<int> &route,
+        const float prevScore,
+        float &bestRating,
+        QVector<Tour> &bestRoutes,
+        const AnswerType answerType)
+{
+    if (isTimeOver())
+        return;
+    ++m_nodes;
+
+    const int iter = route.size();
+    if (iter == size) {
+        const bool isCandidate = answerType == AnswerType::FIRST ? prevScore < bestRating : prevScore <= bestRating;
+        if (!isCandidate)
+            return;
+        // route[city] is the city after it
+        const Tour tour = Tour::fromSuccessors(route);
+        if (tour.isEmpty()) {
+            addLog(QString("Полученный путь не является замкнутым; Закрытие ветки.\n"));
+            return;
+        }
+        if (prevScore < bestRating) {
+            bestRating = prevScore;
+            bestRoutes = {tour};
+            if (isLogging())
+                addLog(QString("Новый рекорд: %1; Рекордный путь: %2").arg(bestRating).arg(tour.toString()));
+        }
+        else {
+            bestRoutes.push_back(tour);
+            if (isLogging())
+                addLog(QString("Получен старый рекорд: %1; Добавлен путь: %2").arg(bestRating).arg(tour.toString()));
+        }
+        return;
+    }
+
+    for (int i = 0; i < size; ++i) {
+        if (iter == i)
+            continue;
+        const bool isVisited = std::find(route.begin(), route.end(), i) != route.end();
+        if (isVisited)
+            continue;
+
+        const float newScore = prevScore + get(mat, size, iter, i);
+        const bool hasRecord = (bestRating != std::numeric_limits<float>::max());
+
+        QVector<int> newRoute = route;
+        newRoute.push_back(i);
+        if (isLogging()) {
+            QVector<QPoint> currRoute(newRoute.size());
+            for (int i = 0; i < newRoute.size(); ++i)
+                currRoute[i] = QPoint(i, newRoute[i]);
+            addLog(QString("Текущая длина: %1; Текущий путь: %2").arg(newScore).arg(getRouteString(currRoute)));
+        }
+        if (hasRecord) {
+            if (answerType == AnswerType::FIRST && bestRating <= newScore) {
+                if (isLogging())
+                    addLog(QString("Выбранный путь хуже или равен текущему рекорду: %1 <= %2; Закрытие ветки.\n").arg(bestRating).arg(newScore));
+                continue;
+            }
+            else if (answerType == AnswerType::ALL && bestRating < newScore) {
+                if (isLogging())
+                    addLog(QString("Выбранный путь хуже текущего рекорда: %1 < %2; Закрытие ветки.\n").arg(bestRating).arg(newScore));
+                continue;
+            }
+        }
+        bruteForceCalc(mat, size, newRoute, newScore, bestRating, bestRoutes, answerType);
+    }
+}
+
+TspSolver::TraceScope::~TraceScope()
+{
+    if (node != SearchTrace::noNode)
+        solver.m_trace->endNode(node);
+    solver.m_traceNode = parent;
+}
+
+ReductionState &TspSolver::reductionState(const int depth)
+{
+    while (int(m_reductions.size()) <= depth)
+        m_reductions.emplace_back();
+    return m_reductions[depth];
+}
+
+quint32 TspSolver::beginTraceNode(const int depth, const QVector<QPoint> &currentRoute, const float rating, const bool isExcludeChild)
+{
+    if (m_trace == nullptr)
+        return SearchTrace::noNode;
+    if (depth == 0)
+        return m_trace->beginNode(m_traceNode, SearchTrace::Branch::ROOT, QPoint(-1, -1), depth, rating);
+    if (isExcludeChild)
+        return m_trace->beginNode(m_traceNode, SearchTrace::Branch::EXCLUDE, m_excludedPaths.last(), depth, rating);
+    return m_trace->beginNode(m_traceNode, SearchTrace::Branch::INCLUDE, currentRoute.last(), depth, rating);
+}
+
+void TspSolver::setBranching(const BranchingStrategy::Type type)
+{
+    m_branching = BranchingStrategy::create(type);
+    m_probeBranching = BranchingStrategy::create(type);
+}
+
+void TspSolver::updateEstimate(const float nodeRating, const float bestRating, const AnswerType answerType)
+{
+    m_estimator->setIncumbent(bestRating);
+    const size_t timeInNs = elapsedInNs();
+    const size_t probeBudgetInNs = m_estimator->probeBudgetInNs(timeInNs);
+    if (probeBudgetInNs > 0) {
+        double nodes = 0.;
+        if (probeTree(bestRating, answerType, timeInNs + probeBudgetInNs, nodes))
+            m_estimator->addProbe(nodes, elapsedInNs() - timeInNs);
+        else
+            m_estimator->addAbandonedProbe(elapsedInNs() - timeInNs);
+    }
+    if (!m_estimator->isSampleDue(timeInNs))
+        return;
+
+    SearchEstimator::Sample sample;
+    sample.timeInNs = timeInNs;
+    sample.nodes = m_nodes;
+    sample.upperBound = bestRating;
+    sample.lowerBound = qMin(nodeRating, bestRating);
+    for (const float bound : m_openBounds)
+        sample.lowerBound = qMin(sample.lowerBound, bound);
+    m_estimator->addSample(sample);
+    if (m_progressCallback)
+        m_progressCallback(m_estimator->estimate());
+}
+
+bool TspSolver::probeTree(const float bestRating, const AnswerType answerType, const size_t deadlineInNs, double &nodes)
+{
+    const int size = m_probeSize;
+    m_probeBuffer.resize(size * size);
+    std::copy(m_probeMat.constData(), m_probeMat.constData() + size * size, m_probeBuffer.data());
+    QVector<QPoint> route = m_probeRoute;
+    float rating = m_probeRating;
+    bool needToSimplify = true;
+    nodes = 1.;
+    double levelWidth = 1.; // Product of branching factors down to the current level
+    // Same steps as calcNode, one child per level
+    for (int level = 0; ; ++level) {
+        if (level > 0 && elapsedInNs() > deadlineInNs) // A level is O(size^2), the clock is cheap next to it
+            return false;
+        const float simplifyRating = simplifyMatrix(m_probeBuffer, size);
+        if (needToSimplify)
+            rating += simplifyRating;
+        if (isWorseThanRecord(rating, bestRating, answerType))
+            break;
+        QPoint zeroPos;
+        float score = 0.f;
+        if (!m_probeBranching->choose(m_probeBuffer, size, route, zeroPos, score))
+            break;
+
+        // Include child is always entered, exclude child only if its bound survives
+        const float secondRating = rating + score;
+        const bool hasExcludeChild = !isWorseThanRecord(secondRating, bestRating, answerType);
+        if (hasExcludeChild)
+            levelWidth *= 2.;
+        nodes += levelWidth;
+        if (hasExcludeChild && m_estimator->randomChild() == 1) {
+            get(m_probeBuffer, size, zeroPos.x(), zeroPos.y()) = -1;
+            rating = secondRating;
+            needToSimplify = false;
+        }
+        else {
+            includePath(m_probeBuffer, size, zeroPos, route);
+            route.push_back(zeroPos);
+            needToSimplify = true;
+        }
+    }
+    return true;
+}
+
+void TspSolver::startClock()
+{
+    m_nodes = 0;
+    m_timedOut = false;
+    m_excludedPaths.clear();
+    m_openSubproblems.clear();
+    m_traceNode = SearchTrace::noNode;
+    m_branching->resetStatistics();
+    if (m_trace != nullptr)
+        m_trace->clear();
+    if (m_estimator != nullptr)
+        m_estimator->clear();
+    m_openBounds.clear();
+    m_probeSize = 0;
+    m_startTime = std::chrono::steady_clock::now();
+    m_deadline = m_startTime + std::chrono::milliseconds(m_timeLimitInMs);
+}
+
+void TspSolver::finishResult(Result &result)
+{
+    result.timeInNs = elapsedInNs();
+    result.nodes = m_nodes;
+    result.timedOut = m_timedOut;
+    result.openSubproblems = m_openSubproblems;
+    result.branching = m_branching->type();
+    result.lookaheads = m_branching->lookaheads();
+    if (m_estimator != nullptr && m_probeSize > 0) {
+        SearchEstimator::Sample sample;
+        sample.timeInNs = result.timeInNs;
+        sample.nodes = m_nodes;
+        sample.upperBound = result.length;
+        const bool isComplete = !m_timedOut && m_openSubproblems.isEmpty();
+        sample.lowerBound = isComplete ? result.length : m_estimator->estimate().lowerBound;
+        m_estimator->addLastSample(sample, isComplete);
+        result.estimate = m_estimator->estimate();
+        if (m_progressCallback)
+            m_progressCallback(result.estimate);
+    }
+    m_openSubproblems.clear();
+}
+
+size_t TspSolver::elapsedInNs() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_startTime).count();
+}
+
+bool TspSolver::isTimeOver()
+{
+    if (m_timedOut)
+        return true;
+    if ((m_nodes & 0x3ff) != 0) // Check clock and cancel flag once per 1024 nodes
+        return false;
+    if (m_cancel != nullptr && m_cancel->load(std::memory_order_relaxed)) {
+        m_timedOut = true;
+        return true;
+    }
+    if (m_timeLimitInMs == 0)
+        return false;
+    m_timedOut = std::chrono::steady_clock::now() >= m_deadline;
+    return m_timedOut;
+}
+
+QVector<float> &TspSolver::nodeBuffer(std::deque<QVector<float>> &buffers, const int depth, const int count)
+{
+    while (int(buffers.size()) <= depth)
+        buffers.emplace_back();
+    QVector<float> &buffer = buffers[depth];
+    if (buffer.size() != count) {
+        buffer.resize(count);
+        if (count >= MatrixKernels::parallelSize * MatrixKernels::parallelSize)
+            MatrixKernels::adviseHugePages(buffer.data(), size_t(buffer.size()) * sizeof(float));
+    }
+    return buffer;
+}
@@ -0,0 +1,286 @@
+#ifndef TSPSOLVER_H
+#define TSPSOLVER_H
+
+#include <QVector>
+#include <QPoint>
+#include <QString>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+
+#include "branchingstrategy.h"
+#include "reductionstate.h"
+#include "searchestimator.h"
+#include "searchtrace.h"
+#include "sparsegraph.h"
+#include "tour.h"
+
+enum class AnswerType : int {
+    FIRST,
+    ALL
+};
+
+// Branch and bound / bruteforce engine without any UI dependency.
+// One instance keeps its node buffers between runs, so reusing the
+// same solver (e.g. one per worker thread) avoids reallocations.
+class TspSolver
+{
+public:
+    // Largest number of cities: size * size fits an int and the matrix stays under 512 MB
+    static constexpr int maxSize = 11585;
+
+    // Independent part of the search tree: tours that contain every
+    // included path and none of the excluded ones
+    struct Subproblem {
+        QVector<QPoint> included;
+        QVector<QPoint> excluded;
+        float bound = 0.f;
+    };
+
+    struct PresolveStatistics {
+        bool isDone = false;
+        bool isExhausted = false; // Nothing is left to search after presolve
+        float lowerBound = 0.f;
+        float upperBound = std::numeric_limits<float>::max(); // Heuristic tour length
+        int nEdges = 0;
+        int nRemoved = 0;
+        int nFixed = 0;
+        size_t timeInNs = 0;
+    };
+
+    struct Result {
+        float length = std::numeric_limits<float>::max();
+        QVector<Tour> routes;
+        size_t nodes = 0;
+        size_t timeInNs = 0;
+        bool timedOut = false;
+        // Nodes left unexplored because of the node limit
+        QVector<Subproblem> openSubproblems;
+        PresolveStatistics presolve;
+        BranchingStrategy::Type branching = BranchingStrategy::Type::MAX_PENALTY;
+        size_t lookaheads = 0; // Child bounds computed by strong branching
+        SearchEstimator::Estimate estimate; // Last estimate of the run, see setEstimator
+        bool isSparse = false; // Branch and bound ran on edge lists, see SparseGraph
+
+        bool hasRoute() const { return !routes.isEmpty(); }
+    };
+
+    using Logger = std::function<void(const QString &)>;
+    using RecordCallback = std::function<void(const float rating, const Tour &tour)>;
+    using ProgressCallback = std::function<void(const SearchEstimator::Estimate &estimate)>;
+
+    TspSolver() = default;
+
+    // Empty logger disables logging (and all log string building). With a logger every node
+    // copies and reduces the whole matrix for the log, the incremental reduction (see
+    // ReductionState) is only used without one.
+    void setLogger(const Logger &logger) { m_logger = logger; }
+    // 0 means no time limit
+    void setTimeLimit(const size_t timeLimitInMs) { m_timeLimitInMs = timeLimitInMs; }
+    // 0 means no limit, see Result::openSubproblems
+    void setNodeLimit(const size_t nodeLimit) { m_nodeLimit = nodeLimit; }
+    // Record found by someone else (e.g. another process), used only for pruning
+    void setSharedBound(const std::atomic<float> *bound) { m_sharedBound = bound; }
+    // The run stops like on its time limit once *cancel is set (checked once per 1024 nodes), nullptr disables
+    void setCancelFlag(const std::atomic<bool> *cancel) { m_cancel = cancel; }
+    // Called on every new record
+    void setRecordCallback(const RecordCallback &callback) { m_recordCallback = callback; }
+    // Run Presolve before branch and bound (matrix engine only)
+    void setPresolve(const bool enabled) { m_presolve = enabled; }
+    // Branching rule of branch and bound (not of splitProblem, it always uses the max penalty)
+    void setBranching(const BranchingStrategy::Type type);
+    BranchingStrategy::Type branching() const { return m_branching->type(); }
+    // Records the branch and bound tree into trace (cleared on every run), nullptr disables
+    void setTrace(SearchTrace *trace) { m_trace = trace; }
+    // Estimates tree size and remaining time of branch and bound (cleared on every run), nullptr disables
+    void setEstimator(SearchEstimator *estimator) { m_estimator = estimator; }
+    // Called on every estimator sample
+    void setProgressCallback(const ProgressCallback &callback) { m_progressCallback = callback; }
+
+    Result solveBranchAndBound(const QVector<float> &mat, const int size, const AnswerType answerType);
+    // Runs on edge lists if graph.isSparse() and branching is MAX_PENALTY, on its matrix otherwise.
+    // The edge list engine has no presolve, logging or estimate.
+    Result solveBranchAndBound(const SparseGraph &graph, const AnswerType answerType);
+    Result solveBruteForce(const QVector<float> &mat, const int size, const AnswerType answerType);
+    // Searches only tours of subproblem which are better than incumbent (or equal for AnswerType::ALL)
+    Result solveSubproblem(
+            const QVector<float> &mat,
+            const int size,
+            const Subproblem &subproblem,
+            const AnswerType answerType,
+            const float incumbent);
+
+    // Expands the top of the search tree until there are at least count open subproblems.
+    // Complete tours met on the way update bestRating and bestRoutes.
+    static QVector<Subproblem> splitProblem(
+            const QVector<float> &mat,
+            const int size,
+            const Subproblem &root,
+            const int count,
+            const AnswerType answerType,
+            float &bestRating,
+            QVector<Tour> &bestRoutes);
+    // Builds matrix of subproblem from the original one, returns length of included paths
+    static float applySubproblem(
+            const QVector<float> &mat,
+            const int size,
+            const Subproblem &subproblem,
+            QVector<float> &subMat);
+    static bool isWorseThanRecord(const float rating, const float bestRating, const AnswerType answerType);
+
+    // Routine functions
+    template<class T>
+    static inline T &get(QVector<T>& mat, const int size, const int row, const int col) { return mat[row + col * size]; }
+    template<class T>
+    static inline float get(const QVector<T>& mat, const int size, const int row, const int col) { return mat[row + col * size]; }
+    static QString getConvertedTime(const size_t timeInNs);
+    static QString getMatrixString(const QVector<float>& mat, const int size);
+    static QString getRouteString(const QVector<QPoint>& route);
+    static QString getPresolveString(const PresolveStatistics &statistics);
+    static QString getEstimateString(const SearchEstimator::Estimate &estimate);
+    static bool findPivotZero(const QVector<float>& mat, const int size, QPoint &zeroPos, float &score);
+    // Row and column minimum of every line without one of its zeros
+    static void fillPenalties(
+            const QVector<float>& mat,
+            const int size,
+            QVector<float> &rowScore,
+            QVector<float> &colScore);
+    // Includes newPath into mat in place (removes its row, column and the closing subtour edge)
+    static void includePath(
+            QVector<float>& mat,
+            const int size,
+            const QPoint &newPath,
+            const QVector<QPoint> &currentRoute);
+    static float simplifyMatrix(QVector<float>& mat, const int size);
+    // Path closing a subtour with newPath, (-1, -1) when newPath is one of the last two
+    static QPoint getSubtourPath(const int size, const QPoint &newPath, const QVector<QPoint> &currentRoute);
+
+    // Edge list counterparts of the functions above: weights has a value per edge of graph,
+    // -1 for removed edges. Results are the same as on the matrix of the graph.
+    static float simplifyEdges(const SparseGraph &graph, QVector<float> &weights);
+    static bool findPivotEdge(const SparseGraph &graph, const QVector<float> &weights, int &edge, float &score);
+    static void includeEdge(
+            const SparseGraph &graph,
+            QVector<float> &weights,
+            const int edge,
+            const QVector<QPoint> &currentRoute);
+
+private:
+    // Ends the trace node of calcNode on every return
+    struct TraceScope {
+        TspSolver &solver;
+        const quint32 node;
+        const quint32 parent;
+        ~TraceScope();
+    };
+
+    // Gives the parent node its matrix back when an in-place node returns
+    struct RestoreScope {
+        ReductionState *state;
+        QVector<float> &mat;
+        ~RestoreScope() { if (state != nullptr) state->restore(mat); }
+    };
+
+    bool isLogging() const { return bool(m_logger); }
+    void addLog(const QString &string) { if (m_logger) m_logger(string); }
+    void startClock();
+    bool isTimeOver();
+    void finishResult(Result &result);
+    QVector<float> &nodeBuffer(std::deque<QVector<float>> &buffers, const int depth, const int count);
+    ReductionState &reductionState(const int depth);
+    quint32 beginTraceNode(const int depth, const QVector<QPoint> &currentRoute, const float rating, const bool isExcludeChild);
+    void setTraceOutcome(const quint32 node, const SearchTrace::Outcome outcome) { if (node != SearchTrace::noNode) m_trace->setOutcome(node, outcome); }
+    size_t elapsedInNs() const;
+    // Probes and samples of m_estimator, nodeRating is the bound of the current node
+    void updateEstimate(const float nodeRating, const float bestRating, const AnswerType answerType);
+    // Knuth probe: random dive from the root of the run, nodes receives its tree size estimate.
+    // Returns false if the dive was abandoned at deadlineInNs (see elapsedInNs).
+    bool probeTree(const float bestRating, const AnswerType answerType, const size_t deadlineInNs, double &nodes);
+
+    // Recursive branch and bound
+    void calcNode(
+            const QVector<float> &mat,
+            const int size,
+            const int depth,
+            const QVector<QPoint> &currentRoute,
+            const float topNodeRating,
+            float &bestRating,
+            QVector<Tour> &bestRoute,
+            const bool needToSimplify,
+            const AnswerType answerType);
+
+    // Recursive branch and bound on edge lists, same tree as calcNode with MAX_PENALTY
+    void calcSparseNode(
+            const SparseGraph &graph,
+            const QVector<float> &weights,
+            const int depth,
+            const QVector<QPoint> &currentRoute,
+            const float topNodeRating,
+            float &bestRating,
+            QVector<Tour> &bestRoute,
+            const bool needToSimplify,
+            const AnswerType answerType);
+    // Node without a pivot: complete tour or dead end
+    void finishBranch(
+            const int size,
+            const QVector<QPoint> &currentRoute,
+            const float currentRating,
+            float &bestRating,
+            QVector<Tour> &bestRoute,
+            const AnswerType answerType,
+            const quint32 traceNode);
+
+    // Recursive bruteforce
+    void bruteForceCalc(
+            const QVector<float> &mat,
+            const int size,
+            const QVector<int> &route,
+            const float prevScore,
+            float &bestRating,
+            QVector<Tour> &bestRoutes,
+            const AnswerType answerType);
+
+private:
+    Logger m_logger;
+    RecordCallback m_recordCallback;
+    const std::atomic<float> *m_sharedBound = nullptr;
+    const std::atomic<bool> *m_cancel = nullptr;
+    size_t m_timeLimitInMs = 0;
+    size_t m_nodeLimit = 0;
+    bool m_presolve = false;
+    std::unique_ptr<BranchingStrategy> m_branching = BranchingStrategy::create(BranchingStrategy::Type::MAX_PENALTY);
+    // Same rule for probes, so they do not touch statistics and buffers of m_branching
+    std::unique_ptr<BranchingStrategy> m_probeBranching = BranchingStrategy::create(BranchingStrategy::Type::MAX_PENALTY);
+    std::chrono::steady_clock::time_point m_startTime;
+    std::chrono::steady_clock::time_point m_deadline;
+    size_t m_nodes = 0;
+    bool m_timedOut = false;
+    QVector<QPoint> m_excludedPaths; // Excluded paths of the current node
+    QVector<Subproblem> m_openSubproblems;
+    SearchTrace *m_trace = nullptr;
+    quint32 m_traceNode = SearchTrace::noNode; // Node of the current calcNode
+    SearchEstimator *m_estimator = nullptr;
+    ProgressCallback m_progressCallback;
+    QVector<float> m_openBounds; // Bounds of exclude children waiting on the current path
+    // Root of the run for probes, m_probeSize is 0 until branch and bound starts
+    QVector<float> m_probeMat;
+    QVector<QPoint> m_probeRoute;
+    float m_probeRating = 0.f;
+    int m_probeSize = 0;
+
+    // Warm per-depth buffers (matrices or edge weights): references stay valid while the deque grows
+    std::deque<QVector<float>> m_nodeBuffers;
+    std::deque<QVector<float>> m_childBuffers;
+    // Without logging all calcNode nodes share m_nodeBuffers[0]: a child applies its path to it,
+    // m_reductions[depth] tells which lines to reduce again and what to restore (see ReductionState)
+    std::deque<ReductionState> m_reductions;
+    QPoint m_subtourPath; // Subtour path of the include child being entered
+    QVector<float> m_presolveBuffer;
+    QVector<float> m_probeBuffer;
+};
+
+#endif // TSPSOLVER_H